@@ -0,0 +1,457 @@
+/**
+ * @file autonEditor.cpp
+ *
+ * This file defines the brain-screen auton editor, which edits an auton
+ * by touch, on a map of the field.
+ */
+
+#include "main.h"
+#include "autonEditor.hpp"
+#include "autonomous.hpp"
+#include "catOS.hpp"
+#include "display.hpp"
+#include "input.hpp"
+#include "state.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
+///Width & height of the field map, in pixels.
+const lv_coord_t fieldPixels = 216;
+///Width & height of a waypoint handle, in pixels.
+const lv_coord_t handleSize = 14;
+///Time between checks for parts of the editor to redraw, in ms.
+const uint32_t editorRefreshPeriod = 50;
+
+/**
+ * Parts of the editor to redraw. Actions mark them here, and refresh()
+ * redraws them from LVGL's task afterwards, as redrawing deletes objects
+ * and an action can't delete the object that called it.
+ */
+enum Dirty {
+  CLEAN        = 0,
+  PATH         = 1, ///< Path & waypoint handles
+  LIST         = 2, ///< Motion list
+  VALUES       = 4, ///< Value buttons of the selected motion
+  ALL          = 7,
+  CLOSE_KEYPAD = 8, ///< Keypad is done with
+  CLOSE_TYPES  = 16 ///< Motion type picker is done with
+};
+
+///Auton being edited, or nullptr.
+static json* editing = nullptr;
+///Index of the selected motion. New motions go after it.
+static int selected = 0;
+static int dirty = CLEAN;
+///Set to close the editor, from either task.
+static std::atomic_bool closing{false};
+///Whether the editor is on screen. Cleared by refresh() once it's deleted.
+static std::atomic_bool editorOpen{false};
+///Set by editAutonOnBrain() for updateAutonEditor() to build the editor.
+static std::atomic_bool editorRequested{false};
+
+static lv_obj_t *root, *field, *pathLine, *motionList, *valueButtons, *keypad, *typePicker;
+static lv_style_t pathStyle, handleStyle, selectedStyle, panelStyle;
+static std::vector<lv_obj_t*> handles;
+static std::vector<lv_point_t> pathPoints;
+///Labels of the value buttons, the keys they edit, and the button map made of the labels.
+static std::vector<std::string> valueLabels, valueKeys;
+static std::vector<const char*> valueMap;
+static std::vector<const char*> typeMap;
+///Key the keypad is editing, and the index of the motion it belongs to.
+static std::string keypadKey;
+static int keypadMotion;
+static lv_obj_t *keypadText;
+///Signal functions that handles & the field had before the editor's own.
+static lv_signal_func_t handleAncestorSignal, fieldAncestorSignal;
+
+static lv_coord_t toPixelsX(double x) { return std::lround(x * fieldPixels / 144); }
+static lv_coord_t toPixelsY(double y) { return fieldPixels - std::lround(y * fieldPixels / 144); }
+static double toInches(lv_coord_t pixels) {
+  //Tenths of an inch are plenty for a finger.
+  return std::clamp(std::round(pixels * 1440.0 / fieldPixels) / 10, 0.0, 144.0);
+}
+
+///Offset runMotion() tracks for the motion at idx, in inches.
+static void offsetAt(int idx, double& x, double& y) {
+  x = y = 0;
+  for(int i = 0; i < idx && i < (int)editing->size(); i++) {
+    auto &motion = (*editing)[i];
+    const std::string type = motion.value("type", "");
+    if(type == "origin" || type == "delta") {
+      x = motion.value("x", 0.0);
+      y = motion.value("y", 0.0);
+    }
+  }
+}
+
+///Default motion of a type, from motionTemplates().
+static const json& templateFor(const std::string& type) {
+  auto &templates = motionTemplates();
+  for(auto &motion: templates) {
+    if(motion.motion["type"] == type) return motion.motion;
+  }
+  return templates.front().motion;
+}
+
+///Inserts a motion after the selected one, and selects it.
+static json& insertMotion(const json& motion) {
+  const int idx = editing->empty() ? 0 : std::min<int>(selected + 1, editing->size());
+  editing->insert(editing->begin() + idx, motion);
+  selected = idx;
+  dirty |= ALL;
+  return (*editing)[idx];
+}
+
+static void restyleHandles() {
+  for(auto *handle: handles) {
+    lv_obj_set_style(handle, (int)lv_obj_get_free_num(handle) == selected ? &selectedStyle : &handleStyle);
+  }
+}
+
+static lv_res_t handleSignal(lv_obj_t* handle, lv_signal_t sign, void* param) {
+  lv_res_t res = handleAncestorSignal(handle, sign, param);
+  if(res != LV_RES_OK) return res;
+  const int idx = lv_obj_get_free_num(handle);
+  if(sign == LV_SIGNAL_PRESSED) {
+    selected = idx;
+    restyleHandles();
+    dirty |= LIST | VALUES;
+  } else if(sign == LV_SIGNAL_DRAG_END) {
+    auto &motion = (*editing)[idx];
+    double x = toInches(lv_obj_get_x(handle) + handleSize / 2);
+    double y = toInches(fieldPixels - (lv_obj_get_y(handle) + handleSize / 2));
+    //Positions are relative to the offset, origins aren't.
+    if(motion["type"] == "position") {
+      double offsetX, offsetY;
+      offsetAt(idx, offsetX, offsetY);
+      x -= offsetX;
+      y -= offsetY;
+    }
+    motion["x"] = x;
+    motion["y"] = y;
+    dirty |= ALL;
+  }
+  return res;
+}
+
+static lv_res_t fieldSignal(lv_obj_t* obj, lv_signal_t sign, void* param) {
+  lv_res_t res = fieldAncestorSignal(obj, sign, param);
+  if(res != LV_RES_OK || sign != LV_SIGNAL_RELEASED) return res;
+  lv_point_t point;
+  lv_area_t area;
+  lv_indev_get_point(lv_indev_get_act(), &point);
+  lv_obj_get_coords(field, &area);
+  auto &inserted = insertMotion(templateFor("position"));
+  double offsetX, offsetY;
+  offsetAt(selected, offsetX, offsetY);
+  inserted["x"] = toInches(point.x - area.x1) - offsetX;
+  inserted["y"] = toInches(fieldPixels - (point.y - area.y1)) - offsetY;
+  return res;
+}
+
+/**
+ * Whether the field, and its handles, take touches. They don't while the
+ * keypad or the type picker is open, as selecting another motion there
+ * would change what those edit.
+ */
+static bool fieldClickable() {
+  return !keypad && !typePicker;
+}
+
+static void setFieldClickable(bool clickable) {
+  lv_obj_set_click(field, clickable);
+  for(auto *handle: handles) lv_obj_set_click(handle, clickable);
+}
+
+static void refreshPath() {
+  for(auto *handle: handles) lv_obj_del(handle);
+  handles.clear();
+  auto plan = planAuton(*editing, false);
+  pathPoints.clear();
+  for(auto &point: plan) {
+    pathPoints.push_back({toPixelsX(point.x), toPixelsY(point.y)});
+  }
+  lv_line_set_points(pathLine, pathPoints.data(), pathPoints.size());
+  for(size_t i = 0; i < plan.size(); i++) {
+    //Only the point a motion ends at gets a handle.
+    if(i + 1 < plan.size() && plan[i + 1].motion == plan[i].motion) continue;
+    const std::string type = (*editing)[plan[i].motion].value("type", "");
+    if(type != "position" && type != "origin") continue;
+    lv_obj_t* handle = lv_obj_create(field, NULL);
+    lv_obj_set_size(handle, handleSize, handleSize);
+    lv_obj_set_pos(handle, pathPoints[i].x - handleSize / 2, pathPoints[i].y - handleSize / 2);
+    lv_obj_set_drag(handle, true);
+    lv_obj_set_click(handle, fieldClickable());
+    lv_obj_set_free_num(handle, plan[i].motion);
+    if(!handleAncestorSignal) handleAncestorSignal = lv_obj_get_signal_func(handle);
+    lv_obj_set_signal_func(handle, handleSignal);
+    handles.push_back(handle);
+  }
+  restyleHandles();
+}
+
+static lv_res_t listAction(lv_obj_t* button) {
+  selected = lv_obj_get_free_num(button);
+  dirty |= ALL;
+  return LV_RES_OK;
+}
+
+static void refreshList() {
+  if(motionList) lv_obj_del(motionList);
+  motionList = lv_list_create(root, NULL);
+  lv_obj_set_pos(motionList, 240, 8);
+  lv_obj_set_size(motionList, 232, 122);
+  lv_obj_t* focus = NULL;
+  for(int i = 0; i < (int)editing->size(); i++) {
+    auto &motion = (*editing)[i];
+    std::string label = std::to_string(i + 1) + " " + motion.value("name", motion.value("type", ""));
+    lv_obj_t* button = lv_list_add(motionList, NULL, label.c_str(), listAction);
+    lv_obj_set_free_num(button, i);
+    if(i == selected) {
+      lv_btn_set_state(button, LV_BTN_STATE_TGL_REL);
+      focus = button;
+    }
+  }
+  if(focus) lv_list_focus(focus, false);
+}
+
+//Number pad, built from a button matrix as PROS's LVGL leaves lv_kb out.
+static lv_res_t keypadAction(lv_obj_t* buttons, const char* text) {
+  const std::string pressed = text;
+  if(pressed == "Del") {
+    lv_ta_del_char(keypadText);
+  } else if(pressed == "Cancel") {
+    dirty |= CLOSE_KEYPAD;
+  } else if(pressed == "OK") {
+    const char* typed = lv_ta_get_text(keypadText);
+    char* end;
+    double value = std::strtod(typed, &end);
+    if(end != typed && keypadMotion < (int)editing->size()) {
+      //Orientations are stored in radians, but typed in degrees.
+      if(keypadKey == "o") value *= PI / 180;
+      (*editing)[keypadMotion][keypadKey] = value;
+      dirty |= ALL;
+    }
+    dirty |= CLOSE_KEYPAD;
+  } else {
+    lv_ta_add_text(keypadText, text);
+  }
+  return LV_RES_OK;
+}
+
+static void openKeypad(const std::string& key) {
+  if(keypad) return;
+  static const char* keypadMap[] = {
+    "1", "2", "3", "Del", "\n",
+    "4", "5", "6", "Cancel", "\n",
+    "7", "8", "9", "OK", "\n",
+    "-", "0", ".", ""
+  };
+  keypadKey = key;
+  keypadMotion = selected;
+  double value = (*editing)[selected][key].get<double>();
+  if(key == "o") value *= 180 / PI;
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%g", value);
+  keypad = lv_obj_create(root, NULL);
+  lv_obj_set_style(keypad, &panelStyle);
+  lv_obj_set_pos(keypad, 240, 0);
+  lv_obj_set_size(keypad, 240, 240);
+  lv_obj_t* label = lv_label_create(keypad, NULL);
+  lv_label_set_text(label, (key + (key == "o" ? " (deg)" : "")).c_str());
+  lv_obj_set_pos(label, 8, 14);
+  keypadText = lv_ta_create(keypad, NULL);
+  lv_ta_set_one_line(keypadText, true);
+  lv_ta_set_text(keypadText, buf);
+  lv_obj_set_pos(keypadText, 80, 4);
+  lv_obj_set_size(keypadText, 152, 40);
+  lv_obj_t* pad = lv_btnm_create(keypad, NULL);
+  lv_btnm_set_map(pad, keypadMap);
+  lv_btnm_set_action(pad, keypadAction);
+  lv_obj_set_pos(pad, 0, 50);
+  lv_obj_set_size(pad, 240, 190);
+  setFieldClickable(false);
+}
+
+static lv_res_t valueAction(lv_obj_t* buttons, const char* text) {
+  auto found = std::find(valueLabels.begin(), valueLabels.end(), text);
+  if(found == valueLabels.end() || selected >= (int)editing->size()) return LV_RES_OK;
+  const std::string key = valueKeys[found - valueLabels.begin()];
+  auto &value = (*editing)[selected][key];
+  if(value.is_boolean()) {
+    value = !value.get<bool>();
+    dirty |= ALL;
+  } else {
+    openKeypad(key);
+  }
+  return LV_RES_OK;
+}
+
+static void refreshValues() {
+  valueLabels.clear();
+  valueKeys.clear();
+  valueMap.clear();
+  if(selected < (int)editing->size()) {
+    for(auto &[key, value]: (*editing)[selected].items()) {
+      if(key == "type" || key == "name") continue;
+      char buf[32];
+      if(value.is_boolean()) {
+        snprintf(buf, sizeof(buf), "%s %s", key.c_str(), value.get<bool>() ? "on" : "off");
+      } else if(value.is_number()) {
+        snprintf(buf, sizeof(buf), "%s %.*f", key.c_str(), key == "o" ? 1 : 2,
+          value.get<double>() * (key == "o" ? 180 / PI : 1));
+      } else {
+        continue;
+      }
+      valueLabels.push_back(buf);
+      valueKeys.push_back(key);
+    }
+  }
+  if(valueLabels.empty()) {
+    valueLabels.push_back("No values");
+    valueKeys.push_back("");
+  }
+  for(size_t i = 0; i < valueLabels.size(); i++) {
+    if(i && i % 3 == 0) valueMap.push_back("\n");
+    valueMap.push_back(valueLabels[i].c_str());
+  }
+  valueMap.push_back("");
+  lv_btnm_set_map(valueButtons, valueMap.data());
+}
+
+static lv_res_t typeAction(lv_obj_t* buttons, const char* text) {
+  for(auto &motion: motionTemplates()) {
+    if(motion.name == text) insertMotion(motion.motion);
+  }
+  dirty |= CLOSE_TYPES;
+  return LV_RES_OK;
+}
+
+static void openTypePicker() {
+  if(typePicker) return;
+  if(typeMap.empty()) {
+    auto &templates = motionTemplates();
+    for(size_t i = 0; i < templates.size(); i++) {
+      if(i && i % 4 == 0) typeMap.push_back("\n");
+      typeMap.push_back(templates[i].name.c_str());
+    }
+    typeMap.push_back("Cancel");
+    typeMap.push_back("");
+  }
+  typePicker = lv_btnm_create(root, NULL);
+  lv_obj_set_pos(typePicker, 240, 0);
+  lv_obj_set_size(typePicker, 240, 240);
+  lv_btnm_set_map(typePicker, typeMap.data());
+  lv_btnm_set_action(typePicker, typeAction);
+  setFieldClickable(false);
+}
+
+static lv_res_t controlAction(lv_obj_t* buttons, const char* text) {
+  const std::string pressed = text;
+  if(pressed == "Add") {
+    openTypePicker();
+  } else if(pressed == "Delete" && selected < (int)editing->size()) {
+    editing->erase(editing->begin() + selected);
+    selected = std::max(0, std::min<int>(selected, editing->size() - 1));
+    dirty |= ALL;
+  } else if(pressed == "Done") {
+    closing = true;
+  }
+  return LV_RES_OK;
+}
+
+static void refresh(void*) {
+  if(!editorOpen.load()) return;
+  if(closing.load()) {
+    lv_obj_del(root);
+    root = field = pathLine = motionList = valueButtons = keypad = typePicker = NULL;
+    handles.clear();
+    editorOpen = false;
+    return;
+  }
+  if(dirty & CLOSE_KEYPAD && keypad) {
+    lv_obj_del(keypad);
+    keypad = NULL;
+  }
+  if(dirty & CLOSE_TYPES && typePicker) {
+    lv_obj_del(typePicker);
+    typePicker = NULL;
+  }
+  if(dirty & (CLOSE_KEYPAD | CLOSE_TYPES)) setFieldClickable(fieldClickable());
+  if(dirty & PATH) refreshPath();
+  if(dirty & LIST) refreshList();
+  if(dirty & VALUES) refreshValues();
+  dirty = CLEAN;
+}
+
+static void buildEditor() {
+  static bool stylesMade = false;
+  if(!stylesMade) {
+    lv_style_copy(&pathStyle, &lv_style_plain);
+    pathStyle.line.color = LV_COLOR_HEX(0x000000);
+    pathStyle.line.width = 3;
+    lv_style_copy(&handleStyle, &lv_style_plain);
+    handleStyle.body.main_color = LV_COLOR_HEX(0xFFFFFF);
+    handleStyle.body.grad_color = LV_COLOR_HEX(0xFFFFFF);
+    handleStyle.body.border.color = LV_COLOR_HEX(0x000000);
+    handleStyle.body.border.width = 2;
+    handleStyle.body.radius = handleSize / 2;
+    lv_style_copy(&selectedStyle, &handleStyle);
+    selectedStyle.body.main_color = LV_COLOR_HEX(0xFFFF00);
+    selectedStyle.body.grad_color = LV_COLOR_HEX(0xFFFF00);
+    lv_style_copy(&panelStyle, &lv_style_plain);
+    lv_task_create(refresh, editorRefreshPeriod, LV_TASK_PRIO_MID, NULL);
+    stylesMade = true;
+  }
+  root = lv_obj_create(lv_scr_act(), NULL);
+  lv_obj_set_style(root, &panelStyle);
+  lv_obj_set_size(root, 480, 240);
+  field = createField(root, fieldPixels);
+  lv_obj_set_pos(field, 12, 12);
+  if(!fieldAncestorSignal) fieldAncestorSignal = lv_obj_get_signal_func(field);
+  lv_obj_set_signal_func(field, fieldSignal);
+  pathLine = lv_line_create(field, NULL);
+  lv_line_set_style(pathLine, &pathStyle);
+  lv_obj_set_click(pathLine, false);
+  motionList = NULL;
+  valueButtons = lv_btnm_create(root, NULL);
+  lv_obj_set_pos(valueButtons, 240, 134);
+  lv_obj_set_size(valueButtons, 232, 62);
+  lv_btnm_set_action(valueButtons, valueAction);
+  static const char* controlMap[] = {"Add", "Delete", "Done", ""};
+  lv_obj_t* controls = lv_btnm_create(root, NULL);
+  lv_obj_set_pos(controls, 240, 200);
+  lv_obj_set_size(controls, 232, 34);
+  lv_btnm_set_map(controls, controlMap);
+  lv_btnm_set_action(controls, controlAction);
+  keypad = typePicker = NULL;
+}
+
+void editAutonOnBrain(const std::string& name) {
+  auto &autons = getState()["autons"];
+  if(autons.find(name) == autons.end()) return;
+  editing = &autons[name];
+  selected = 0;
+  closing = false;
+  dirty = ALL;
+  editorRequested = true;
+  line_set(0, "On brain screen");
+  line_set(1, "Done there, or");
+  line_set(2, "B here to close");
+  auto &ctrl = menuInput();
+  //updateAutonEditor() sets editorOpen before clearing editorRequested, so there's no gap between them.
+  while(editorRequested.load() || editorOpen.load()) {
+    if(ctrl.newPress(DIGITAL_B)) closing = true;
+    ctrl.wait(menuWaitTimeout);
+  }
+  editing = nullptr;
+}
+
+void updateAutonEditor() {
+  if(!editorRequested.load()) return;
+  buildEditor();
+  editorOpen = true;
+  editorRequested = false;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file autonEditor.hpp
+ *
+ * This file declares the brain-screen auton editor, which edits an auton
+ * by touch, on a map of the field.
+ */
+
+#pragma once
+#include <string>
+
+/**
+ * Opens the brain-screen editor on an auton, and waits for it to close,
+ * either from its Done button or from B on the controller.
+ *
+ * The field map shows the auton's planned path. Waypoints of Position &
+ * Origin motions can be dragged, and tapping the field inserts a Position
+ * motion after the selected one. The motion list selects motions, and
+ * their values are typed on a keypad rather than stepped digit by digit.
+ *
+ * Edits go straight into getState()["autons"], and the caller saves them.
+ * Call from catOS's task, which mustn't touch the auton until this returns.
+ * The editor itself is built by updateAutonEditor(), on the UI task.
+ *
+ * @param name Name of the auton to edit
+ */
+void editAutonOnBrain(const std::string& name);
+
+/**
+ * Builds the editor requested by editAutonOnBrain(), if any. Called by
+ * uiExecutor every cycle, so LVGL objects are only made from that task.
+ */
+void updateAutonEditor();
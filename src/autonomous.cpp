@@ -13,6 +13,9 @@
 #include "debugging.hpp"
 #include "pros/apix.h"
 #include "autoshoot.hpp"
+#include "battery.hpp"
+#include "base.hpp"
+#include "jobs.hpp"
 using namespace std;
 
 ///Whether to execute autonomous motions as on the blue side, or the red side.
@@ -50,11 +53,13 @@ void moveToSetpoint(RoboPosition pt, double velLimit, bool reverse, int extraTim
   //Turn by dTheta radians CCW
   cha.turnAngle(dTheta * -(180.0 / PI) * okapi::degree);
   //Wait for turnExtraTime ms.
-  pros::delay(turnExtraTime);
+  jobDelay(turnExtraTime);
+  //Don't start the second half of a cancelled move.
+  if(jobCancelled()) return;
   //Move by dist degrees
   cha.moveDistance(dist);
   //Wait for extraTime ms.
-  pros::delay(extraTime);
+  jobDelay(extraTime);
 }
 
 void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
@@ -103,22 +108,22 @@ void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
     //Turn by dTheta radians
     bot.base->turnAngle(dTheta * -(180 / PI) * okapi::degree);
     //Wait extra "t" seconds
-    pros::delay(motionObject["t"].get<double>() * 1000);
+    jobDelay(motionObject["t"].get<double>() * 1000);
   }
   //Move puncher to low target
   if(type == "low") {
     bot.puncher.lowTarget();
-    pros::delay(1000 * motionObject["t"].get<double>());
+    jobDelay(1000 * motionObject["t"].get<double>());
   }
   //Move puncher to high target
   if(type == "high") {
     bot.puncher.highTarget();
-    pros::delay(1000 * motionObject["t"].get<double>());
+    jobDelay(1000 * motionObject["t"].get<double>());
   }
   //Punch ball
   if(type == "punch") {
     bot.puncher.shoot();
-    pros::delay(1000 * motionObject["t"].get<double>());
+    jobDelay(1000 * motionObject["t"].get<double>());
   }
   //Spin intake
   if(type == "intake") {
@@ -128,13 +133,13 @@ void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
     //If "t" is set, wait "t" seconds and stop the intake.
     double timing = motionObject["t"].get<double>();
     if(timing != 0) {
-      pros::delay((int)(timing * 1000));
+      jobDelay((int)(timing * 1000));
       bot.intake.moveVelocity(0);
     }
   }
   //Delay by "t" seconds
   if(type == "delay") {
-    pros::delay((int)(1000 * motionObject["t"].get<double>()));
+    jobDelay((int)(1000 * motionObject["t"].get<double>()));
   }
   //Brake Modes
   if(type == "hold") {
@@ -188,11 +193,22 @@ void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
     //Max out max velocity
     bot.base->setMaxVelocity((int) bot.left.getGearing());
     //Respect isBlue by swapping l & r.
-    bot.left.moveVelocity(isBlue ? r : l);
-    bot.right.moveVelocity(isBlue ? l : r);
+    if(isBlue) std::swap(l, r);
+    auto &settings = bot.baseSettings;
+    if(settings.getVoltagePIDUsage()) {
+      //Drive open-loop through the same TrueSpeed curve & battery compensation as the base.
+      TrueSpeedTable trueSpeed(settings.getTrueSpeedData(), settings.getTrueSpeedSmoothing());
+      double scale = settings.getBatteryCompensationUsage() ? getBatteryCompensation() : 1.0;
+      double maxVelocity = (int)bot.left.getGearing();
+      bot.left .moveVoltage(std::clamp(trueSpeed(l / maxVelocity) * scale, -1.0, 1.0) * 12000);
+      bot.right.moveVoltage(std::clamp(trueSpeed(r / maxVelocity) * scale, -1.0, 1.0) * 12000);
+    } else {
+      bot.left.moveVelocity(l);
+      bot.right.moveVelocity(r);
+    }
     //If "t" is set: delay "t" seconds then stop base
     if(motionObject["t"].get<double>() != 0) {
-      pros::delay(motionObject["t"].get<double>() * 1000);
+      jobDelay(motionObject["t"].get<double>() * 1000);
       bot.left.moveVelocity(0);
       bot.right.moveVelocity(0);
     }
@@ -204,7 +220,7 @@ void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
     //"v": Velocity limit in [0, 1]
     bot.scorer.moveAbsolute(position, 100 * motionObject["v"].get<double>());
     //"t": Wait time for scorer to start moving
-    pros::delay(motionObject["t"].get<double>() * 1000);
+    jobDelay(motionObject["t"].get<double>() * 1000);
   }
   //Straight Line
   if(type == "sline") {
@@ -216,7 +232,33 @@ void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
     //Move distance
     bot.base->moveDistance(distance);
     //"t": Extra time to wait after moving
-    pros::delay(motionObject["t"].get<double>() * 1000);
+    jobDelay(motionObject["t"].get<double>() * 1000);
+  }
+  //Arc
+  if(type == "arc") {
+    //"r": Radius in inches, negative to drive backwards
+    double radius = motionObject["r"].get<double>();
+    //"a": Angle to turn clockwise over the arc, in degrees. Mirrored on blue.
+    double angle = motionObject["a"].get<double>() * (isBlue ? -1 : 1);
+    //"v": Velocity limit in [0, 1]
+    bot.base->setMaxVelocity(motionObject["v"].get<double>() * (int)bot.left.getGearing());
+    bot.base->setMaxVoltage(motionObject["v"].get<double>() * 12000);
+    bot.base->arc(radius * okapi::inch, angle * okapi::degree);
+    //"t": Extra time to wait after moving
+    jobDelay(motionObject["t"].get<double>() * 1000);
+  }
+  //Swing turn about one side
+  if(type == "swing") {
+    //"a": Angle to turn clockwise, in degrees. Mirrored on blue.
+    double angle = motionObject["a"].get<double>() * (isBlue ? -1 : 1);
+    //"l": Whether to pivot on the left side instead of the right. Also mirrored on blue.
+    bool lockLeft = motionObject["l"].get<bool>() != isBlue;
+    //"v": Velocity limit in [0, 1]
+    bot.base->setMaxVelocity(motionObject["v"].get<double>() * (int)bot.left.getGearing());
+    bot.base->setMaxVoltage(motionObject["v"].get<double>() * 12000);
+    bot.base->swing(angle * okapi::degree, lockLeft);
+    //"t": Extra time to wait after moving
+    jobDelay(motionObject["t"].get<double>() * 1000);
   }
   //Automatic shot
   if(type == "autoshoot") {
@@ -224,6 +266,111 @@ void runMotion(json motionObject, RoboPosition& offset, bool isBlue) {
   }
 }
 
+const std::vector<MotionTemplate>& motionTemplates() {
+  static const std::vector<MotionTemplate> templates = {
+    {"SLine"    , { {"type", "sline"}, {"d", 0.0}, {"t", 0.2}, {"v", 1.0} }},
+    {"Position" , { {"type", "position"}, {"x", 0.0}, {"y", 0.0}, {"t", 0.2}, {"rT", 0.2}, {"v", 1.0}, {"r", false} }},
+    {"Rotation" , { {"type", "rotateTo"}, {"o", 0.0}, {"t", 0.2}, {"v", 1.0} }},
+    {"Arc"      , { {"type", "arc"}, {"r", 24.0}, {"a", 90.0}, {"t", 0.2}, {"v", 1.0} }},
+    {"Swing"    , { {"type", "swing"}, {"a", 90.0}, {"l", false}, {"t", 0.2}, {"v", 1.0} }},
+    {"Direct"   , { {"type", "direct"}, {"l", 1.0}, {"r", 1.0}, {"t", 1.0} }},
+    {"Low"      , { {"type", "low"}, {"t", 0.0} }},
+    {"High"     , { {"type", "high"}, {"t", 0.0} }},
+    {"Punch"    , { {"type", "punch"}, {"t", 0.0} }},
+    {"Autoshoot", { {"type", "autoshoot"} }},
+    {"Intake"   , { {"type", "intake"}, {"v", 1.0}, {"t", 0.2} }},
+    {"Scorer"   , { {"type", "scorer"}, {"p", 10 }, {"v", 1.0}, {"t", 0.6} }},
+    {"Delta"    , { {"type", "delta"}, {"x", 0.0}, {"y", 0.0}, {"o", 0.0} }},
+    {"Delay"    , { {"type", "delay"}, {"t", 0} }},
+    {"Hold"     , { {"type", "hold"} }},
+    {"Coast"    , { {"type", "coast"} }},
+    {"Short"    , { {"type", "short"} }},
+    {"Origin"   , { {"type", "origin"}, {"name", "ORIGIN"}, {"x", 0.0}, {"y", 0.0}, {"o", 0.0} }}
+  };
+  return templates;
+}
+
+///Largest turn, in radians, between two points of a planned curve.
+const double planArcStep = PI / 12;
+
+std::vector<PathPoint> planAuton(const json& auton, bool isBlue) {
+  auto &gps = getRobot().gps;
+  //Each side travels cpr counts per radian the robot turns, so this is half the track width.
+  const double halfTrack = gps.countsToInch(gps.radiansToCounts(1));
+  std::vector<PathPoint> path;
+  double x = 0, y = 0, o = 0;
+  double offsetX = 0, offsetY = 0, offsetO = 0;
+  for(int i = 0; i < (int)auton.size(); i++) {
+    auto &motion = auton[i];
+    const std::string type = motion.value("type", "");
+    auto addPoint = [&]() {
+      path.push_back({x, y, o, i, offsetX, offsetY, offsetO});
+    };
+    //Turns by dTheta about a centre of curvature radius inches to the robot's left.
+    auto curve = [&](double radius, double dTheta) {
+      const double cx = x - radius * sin(o), cy = y + radius * cos(o);
+      const double rx = x - cx, ry = y - cy, startO = o;
+      const int steps = std::max(1, (int)ceil(fabs(dTheta) / planArcStep));
+      for(int step = 1; step <= steps; step++) {
+        const double turned = dTheta * step / steps;
+        x = cx + rx * cos(turned) - ry * sin(turned);
+        y = cy + rx * sin(turned) + ry * cos(turned);
+        o = startO + turned;
+        addPoint();
+      }
+    };
+    if(type == "origin") {
+      offsetX = motion.value("x", 0.0);
+      offsetY = motion.value("y", 0.0);
+      offsetO = 0;
+      x = isBlue ? 144 - offsetX : offsetX;
+      y = offsetY;
+      o = motion.value("o", 0.0);
+      if(isBlue) o = PI - o;
+      addPoint();
+    } else if(type == "delta") {
+      offsetX = motion.value("x", 0.0);
+      offsetY = motion.value("y", 0.0);
+      offsetO = motion.value("o", 0.0);
+    } else if(type == "position") {
+      double targetX = motion.value("x", 0.0) + offsetX;
+      double targetY = motion.value("y", 0.0) + offsetY;
+      if(isBlue) targetX = 144 - targetX;
+      //moveToSetpoint() faces the point, or faces away from it in reverse, then drives.
+      if(targetX != x || targetY != y) {
+        o = atan2(targetY - y, targetX - x) + (motion.value("r", false) ? PI : 0);
+      }
+      x = targetX;
+      y = targetY;
+      addPoint();
+    } else if(type == "rotateTo") {
+      o = motion.value("o", 0.0) + offsetO;
+      if(isBlue) o = PI - o;
+      addPoint();
+    } else if(type == "sline") {
+      const double d = motion.value("d", 0.0);
+      x += d * cos(o);
+      y += d * sin(o);
+      addPoint();
+    } else if(type == "arc") {
+      const double radius = motion.value("r", 0.0);
+      const double angle = motion.value("a", 0.0) * (isBlue ? -1 : 1) * PI / 180;
+      if(radius == 0 || angle == 0) {
+        o -= angle;
+        addPoint();
+      } else {
+        //The radius of curvature is arc length over turn, so a forward clockwise arc curves about a centre on the right.
+        curve(angle > 0 ? -radius : radius, -angle);
+      }
+    } else if(type == "swing") {
+      const double angle = motion.value("a", 0.0) * (isBlue ? -1 : 1) * PI / 180;
+      const bool lockLeft = motion.value("l", false) != isBlue;
+      curve(lockLeft ? halfTrack : -halfTrack, -angle);
+    }
+  }
+  return path;
+}
+
 void runAuton(json::iterator loc, json::iterator end, bool isBlue) {
   auto &bot = getRobot();
   bot.scorer.tarePosition();
@@ -232,7 +379,17 @@ void runAuton(json::iterator loc, json::iterator end, bool isBlue) {
   bot.right.setBrakeMode(AbstractMotor::brakeMode::coast);
   bot.scorer.setBrakeMode(AbstractMotor::brakeMode::coast);
   RoboPosition tracking = {0, 0, 0};
-  for(; loc != end; loc++) {
+  const bool compensating = bot.baseSettings.getBatteryCompensationUsage();
+  for(int i = 0; loc != end; loc++, i++) {
+    if(jobCancelled()) {
+      printf("Auton cancelled before motion %d\n", i);
+      break;
+    }
+    jobProgress("Motion " + std::to_string(i + 1) + ": " + (*loc)["type"].get<std::string>());
+    //Log the battery compensation each motion runs with.
+    printf("Auton motion %d (%s): battery %.0fmV, compensation %.3f\n", i,
+      (*loc)["type"].get<std::string>().c_str(), getBatteryVoltage(),
+      compensating ? getBatteryCompensation() : 1.0);
     runMotion(*loc, tracking, isBlue);
   }
   bot. left.setBrakeMode(oldBrake);
@@ -9,6 +9,7 @@
 #include "json.hpp"
 #include "gps.hpp"
 #include <string>
+#include <vector>
 using json = nlohmann::json;
 
 /**
@@ -65,3 +66,38 @@ bool getBlue();
  * @param isBlue       Whether to invert turns
  */
 void runMotion(json motionObject, RoboPosition& offset, bool isBlue);
+
+///A kind of motion that editors can insert into an auton.
+struct MotionTemplate {
+  ///Name editors list it by.
+  std::string name;
+  ///Motion to insert, with its "type" and default values.
+  json motion;
+};
+
+/**
+ * Every kind of motion editors can insert, in the order they list them.
+ */
+const std::vector<MotionTemplate>& motionTemplates();
+
+///A pose along an auton's planned path.
+struct PathPoint {
+  ///Position in inches, and orientation in radians.
+  double x, y, o;
+  ///Index of the motion this pose is part of.
+  int motion;
+  ///Offset in effect for that motion, in inches & radians. See runMotion().
+  double offsetX, offsetY, offsetO;
+};
+
+/**
+ * Plans the path of an auton without running it, by following the geometry
+ * of each motion on from the last pose, mirrored for blue like runMotion().
+ * Motions that don't move the base add no points, and arcs & swings add a
+ * point every few degrees so they can be drawn as curves.
+ * 
+ * @param auton  Motion list to plan
+ * @param isBlue Whether to plan for the blue side
+ * @return Poses in order, the last for each motion being where it ends
+ */
+std::vector<PathPoint> planAuton(const json& auton, bool isBlue);
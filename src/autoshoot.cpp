@@ -57,10 +57,13 @@ void autoshoot(int toggleTime, int punchTime) {
 
 void autoshootTask(void*) {
   auto &bot = getRobot();
-  auto &ctrl = bot.controller;
+  InputQueue ctrl;
   while(true) {
+    uint32_t waitStart = pros::millis();
     Elliot::takeCoast();
-    if(ctrl.get_digital_new_press(DIGITAL_A)) {
+    //Presses made while a menu had the robot were meant for the menu.
+    if(pros::millis() - waitStart > inputPeriod) ctrl.clear();
+    if(ctrl.newPress(DIGITAL_A)) {
       //Tell opcontrol autoshoot is active & wait for response
       autoshootActive = true;
 
@@ -0,0 +1,129 @@
+/**
+ * @file autotune.cpp
+ *
+ * This file defines the relay-feedback autotuner, which finds PID gains
+ * for the base by making it oscillate around its starting position.
+ */
+
+#include "main.h"
+#include "autotune.hpp"
+#include "elliot.hpp"
+#include "jobs.hpp"
+#include "base.hpp"
+#include "battery.hpp"
+#include <algorithm>
+#include <cmath>
+
+///Error, in motor degrees, the base must cross before the relay switches. Keeps noise from chattering it.
+const double relayHysteresis = 2;
+///Oscillations to let die down before measuring.
+const int warmupCycles = 2;
+///Oscillations to measure.
+const int measuredCycles = 4;
+///Longest a test may run, in ms.
+const uint32_t relayTimeout = 10000;
+
+const std::vector<std::string>& tuningRuleNames() {
+  static const std::vector<std::string> names = {
+    "Ziegler-Nichols", "Some overshoot", "No overshoot", "Tyreus-Luyben"
+  };
+  return names;
+}
+
+okapi::IterativePosPIDController::Gains gainsFromRule(TuningRule rule, const RelayResult& result) {
+  const double ku = result.ultimateGain, tu = result.ultimatePeriod;
+  //Proportional gain, integral time & derivative time for each rule.
+  double kP, ti, td;
+  switch(rule) {
+    case TuningRule::ZIEGLER_NICHOLS: kP = 0.6  * ku; ti = tu / 2;   td = tu / 8;   break;
+    case TuningRule::SOME_OVERSHOOT:  kP = 0.33 * ku; ti = tu / 2;   td = tu / 3;   break;
+    case TuningRule::NO_OVERSHOOT:    kP = 0.2  * ku; ti = tu / 2;   td = tu / 3;   break;
+    case TuningRule::TYREUS_LUYBEN:   kP = 0.45 * ku; ti = 2.2 * tu; td = tu / 6.3; break;
+    default: return {0, 0, 0, 0};
+  }
+  return {kP, ti > 0 ? kP / ti : 0, kP * td, 0};
+}
+
+bool relayTest(RelayAxis axis, RelayResult& result, double relayAmplitude) {
+  auto &bot = getRobot();
+  //Keep the base's own loop from fighting the relay.
+  bot.base->stop();
+  const uint32_t period = std::max<uint32_t>(1, bot.base->getLoopPeriod().convert(millisecond));
+  const bool voltage = bot.baseSettings.getVoltagePIDUsage();
+  const TrueSpeedTable trueSpeed(bot.baseSettings.getTrueSpeedData(), bot.baseSettings.getTrueSpeedSmoothing());
+  const double maxVelocity = (int)bot.left.getGearing();
+  const double batteryScale = bot.baseSettings.getBatteryCompensationUsage() ? getBatteryCompensation() : 1.0;
+  //Drives each side with a PID output, the same way Elliot2CCPID would.
+  auto drive = [&](double left, double right) {
+    if(voltage) {
+      bot.left .moveVoltage(std::clamp(trueSpeed(left ) * batteryScale, -1.0, 1.0) * 12000);
+      bot.right.moveVoltage(std::clamp(trueSpeed(right) * batteryScale, -1.0, 1.0) * 12000);
+    } else {
+      bot.left .moveVelocity(left  * maxVelocity);
+      bot.right.moveVelocity(right * maxVelocity);
+    }
+  };
+  //Measures the axis like Elliot2CCPID's loop does.
+  auto measure = [&]() {
+    const double l = bot.left.getPosition(), r = bot.right.getPosition();
+    return axis == RelayAxis::DISTANCE ? (l + r) / 2 : (l - r) / 2;
+  };
+
+  const double setpoint = measure();
+  double output = relayAmplitude;
+  //Times at which the relay switched up, and the extremes between those times.
+  uint32_t lastRise = 0;
+  double high = setpoint, low = setpoint;
+  int cycles = 0;
+  double periodSum = 0, amplitudeSum = 0;
+  const uint32_t start = pros::millis();
+  uint32_t now = start;
+  bool aborted = false;
+  while(cycles < warmupCycles + measuredCycles) {
+    if(jobCancelled() || pros::millis() - start > relayTimeout) {
+      aborted = true;
+      break;
+    }
+    const double pos = measure();
+    const double error = setpoint - pos;
+    high = std::max(high, pos);
+    low  = std::min(low , pos);
+    if(output < 0 && error > relayHysteresis) {
+      //A rising switch completes a cycle.
+      output = relayAmplitude;
+      const uint32_t t = pros::millis();
+      if(lastRise) {
+        cycles++;
+        jobProgress("Cycle " + std::to_string(cycles) + "/" + std::to_string(warmupCycles + measuredCycles));
+        if(cycles > warmupCycles) {
+          periodSum += (t - lastRise) / 1000.0;
+          amplitudeSum += (high - low) / 2;
+        }
+      }
+      lastRise = t;
+      high = low = pos;
+    } else if(output > 0 && error < -relayHysteresis) {
+      output = -relayAmplitude;
+    }
+    if(axis == RelayAxis::DISTANCE) {
+      drive(output, output);
+    } else {
+      drive(output, -output);
+    }
+    pros::c::task_delay_until(&now, period);
+  }
+  bot.left .moveVelocity(0);
+  bot.right.moveVelocity(0);
+  if(aborted || cycles <= warmupCycles) return false;
+
+  result.cycles = cycles - warmupCycles;
+  result.ultimatePeriod = periodSum / result.cycles;
+  result.amplitude = amplitudeSum / result.cycles;
+  //Describing function of a relay with hysteresis.
+  const double a = std::sqrt(std::max(result.amplitude * result.amplitude - relayHysteresis * relayHysteresis, 1e-9));
+  result.ultimateGain = 4 * relayAmplitude / (PI * a);
+  printf("Relay test (%s): Ku %f, Tu %f s, amplitude %f deg over %d cycles\n",
+    axis == RelayAxis::DISTANCE ? "distance" : "turn",
+    result.ultimateGain, result.ultimatePeriod, result.amplitude, result.cycles);
+  return true;
+}
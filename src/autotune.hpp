@@ -0,0 +1,66 @@
+/**
+ * @file autotune.hpp
+ *
+ * This file declares the relay-feedback autotuner, which finds PID gains
+ * for the base by making it oscillate around its starting position.
+ */
+
+#pragma once
+#include "okapi/api.hpp"
+#include <string>
+#include <vector>
+
+///Rules for turning an ultimate gain & period into PID gains.
+enum class TuningRule {
+  ZIEGLER_NICHOLS = 0, ///< Classic Ziegler-Nichols, fast but with a lot of overshoot
+  SOME_OVERSHOOT,      ///< Ziegler-Nichols variant with less overshoot
+  NO_OVERSHOOT,        ///< Ziegler-Nichols variant that shouldn't overshoot
+  TYREUS_LUYBEN        ///< Slower & more robust than Ziegler-Nichols
+};
+
+///Names of every TuningRule, in order, for menus & settings.
+const std::vector<std::string>& tuningRuleNames();
+
+///Axis of the base to relay test.
+enum class RelayAxis {
+  DISTANCE, ///< Driving straight, measured like Elliot2CCPID's distance PID
+  TURN      ///< Turning in place, measured like Elliot2CCPID's turn PID
+};
+
+///What a relay test measured.
+struct RelayResult {
+  ///Gain at which the loop would oscillate steadily, in PID output per motor degree.
+  double ultimateGain;
+  ///Period of that oscillation, in seconds.
+  double ultimatePeriod;
+  ///Amplitude of the oscillation, in motor degrees.
+  double amplitude;
+  ///Number of oscillations measured.
+  int cycles;
+};
+
+/**
+ * Derives PID gains from a relay test. kI is per second and kD is in
+ * seconds, as okapi::IterativePosPIDController expects.
+ *
+ * @param rule   Rule to derive gains with
+ * @param result Relay test results
+ */
+okapi::IterativePosPIDController::Gains gainsFromRule(TuningRule rule, const RelayResult& result);
+
+/**
+ * Runs a relay-feedback test on the base's motors. The output is switched
+ * between +amplitude and -amplitude each time the base crosses its starting
+ * position, through the same voltage or velocity path the base's PID uses.
+ * The oscillation's size & period give the ultimate gain & period. This
+ * takes a few seconds, and the robot stays within a few inches of where it
+ * started.
+ *
+ * Cancelling the job running it (see runJob()) aborts the test.
+ *
+ * @param axis           Whether to drive or turn
+ * @param result         Where to write the results
+ * @param relayAmplitude Output to switch between, in [0, 1]
+ * @return Whether the test measured enough oscillations
+ */
+bool relayTest(RelayAxis axis, RelayResult& result, double relayAmplitude = 0.3);
@@ -11,6 +11,8 @@
 #include "elliot.hpp"
 #include "debugging.hpp"
 #include "ccpid_mod.hpp"
+#include "autotune.hpp"
+#include "telemetry.hpp"
 #include <utility>
 #include <functional>
 using json = nlohmann::json;
@@ -19,7 +21,9 @@ using json = nlohmann::json;
  * BaseSettings is responsible for loading/saving configuration for the
  * Elliot2CCPID that controls the base. It loads/saves PID values for
  * turning & going forward, and for angle correction while going forward.
- * Because Elliot2CCPID can't be reconfigured, it is reconstructed whenever
+ * Gains & TrueSpeed data are retuned on the running Elliot2CCPID, so a
+ * movement in progress survives a change. Anything else, like the loop
+ * period, needs a new Elliot2CCPID, which is constructed whenever
  * loadState() is called. This is why it's stored as a unique_ptr in Elliot.
  * 
  * @see Elliot2CCPID
@@ -34,10 +38,16 @@ class BaseSettings {
     MotorGroup& left;
     ///Right MotorGroup to construct Elliot2CCPID with
     MotorGroup& right;
+    ///Left encoder to construct Elliot2CCPID with
+    std::shared_ptr<ContinuousRotarySensor> leftEncoder;
+    ///Right encoder to construct Elliot2CCPID with
+    std::shared_ptr<ContinuousRotarySensor> rightEncoder;
     ///Function to get CPI value to construct Elliot2CCPID with
     std::function<double()> cpiGetter;
     ///Function to get CPR value to construct Elliot2CCPID with
     std::function<double()> cprGetter;
+    ///Trace every Elliot2CCPID pushes to. Kept here, as the base is rebuilt while it's read.
+    TraceRing trace;
 
     /**
      * Load a set of PID gains from the SD card, given the name of the set.
@@ -55,37 +65,143 @@ class BaseSettings {
         };
     }
 
+    /**
+     * Loads feedforward constants & profile limits from getState()["base"]["ff"].
+     * 
+     * @return Feedforward for the base's voltage mode
+     */
+    Feedforward loadFeedforward() {
+        auto &ff = data["ff"];
+        Feedforward ret;
+        ret.kS = ff["kS"].get<double>();
+        ret.kV = ff["kV"].get<double>();
+        ret.kA = ff["kA"].get<double>();
+        ret.maxVelocity = ff["maxVel"].get<double>();
+        ret.maxAcceleration = ff["maxAccel"].get<double>();
+        return ret;
+    }
+
+    /**
+     * Loads a gain schedule from getState()["base"]["schedule"]["<name>"],
+     * an array of {"m", "kP", "kI", "kD"} rows.
+     * 
+     * @param name Name of the schedule, "dist", "angle", or "turn"
+     */
+    GainSchedule loadSchedule(const char* name) {
+        std::vector<GainSchedule::Row> rows;
+        for(auto &row: data["schedule"][name]) {
+            rows.push_back({row["m"].get<double>(), {row["kP"].get<double>(), row["kI"].get<double>(), row["kD"].get<double>(), 0}});
+        }
+        return GainSchedule(rows);
+    }
+
+    /**
+     * Loads a PID's derivative filter & integral options from
+     * getState()["base"]["pidOpts"]["<name>"].
+     * 
+     * @param name Name of the PID, "dist", "angle", or "turn"
+     */
+    PIDOptions loadPIDOptions(const char* name) {
+        auto &opts = data["pidOpts"][name];
+        auto &names = derivativeFilterNames();
+        auto found = std::find(names.begin(), names.end(), opts["filter"].get<std::string>());
+        PIDOptions ret;
+        ret.filter = found == names.end() ? DerivativeFilter::NONE : (DerivativeFilter)(found - names.begin());
+        ret.alpha = opts["alpha"].get<double>();
+        ret.integralLimit = opts["iLimit"].get<double>();
+        ret.integralBand = opts["iBand"].get<double>();
+        ret.integralReset = opts["iReset"].get<bool>();
+        return ret;
+    }
+
+    /**
+     * Constructs one of the base's PIDs with its gains & options.
+     * 
+     * @param name Name of the PID, "dist", "angle", or "turn"
+     */
+    std::unique_ptr<IterativePosPIDController> makePID(const char* name) {
+        auto opts = loadPIDOptions(name);
+        auto pid = std::make_unique<IterativePosPIDController>(loadGains(name), TimeUtilFactory::create(), opts.makeFilter());
+        opts.applyTo(*pid);
+        return pid;
+    }
+
     public:
     /**
      * Constructs a new Elliot2CCPID object from
-     * current SD card data.
+     * current SD card data. The telemetry period is set to the
+     * loop period, since the loop runs once per telemetry tick.
      */
     void loadState() {
-        auto dist = loadGains("dist");
-        auto angle = loadGains("angle");
-        auto turn = loadGains("turn");
+        const int period = std::clamp(data["period"].get<int>(), (int)minTelemetryPeriod, (int)maxTelemetryPeriod);
+        setTelemetryPeriod(period);
         base = std::unique_ptr<Elliot2CCPID>( new Elliot2CCPID(
             TimeUtil(
                 Supplier<std::unique_ptr<AbstractTimer>>([]() { return std::make_unique<Timer>(); }),
                 Supplier<std::unique_ptr<AbstractRate >>([]() { return std::make_unique<Rate >(); }),
                 Supplier<std::unique_ptr<SettledUtil  >>([]() { return std::make_unique<SettledUtil>(std::make_unique<Timer>(), 0.0, 10.0, 325_ms); })
             ),
-            std::make_shared<SkidSteerModel>(std::make_shared<MotorGroup>(left), std::make_shared<MotorGroup>(right), left.getEncoder(), right.getEncoder(), 200, 12000),
-            std::make_unique<IterativePosPIDController>(dist , TimeUtilFactory::create()),
-            std::make_unique<IterativePosPIDController>(angle, TimeUtilFactory::create()),
-            std::make_unique<IterativePosPIDController>(turn , TimeUtilFactory::create()),
+            std::make_shared<Elliot2SkidSteerModel>(std::make_shared<MotorGroup>(left), std::make_shared<MotorGroup>(right), leftEncoder, rightEncoder, 200, 12000),
+            makePID("dist"),
+            makePID("angle"),
+            makePID("turn"),
             AbstractMotor::gearset::green, {
                 (360 / (PI * cpiGetter())) * okapi::inch, ((cprGetter() * 2) / cpiGetter()) * okapi::inch
             },
             getTrueSpeedData(),
-            data["voltage"].get<bool>()
+            data["tsSmooth"].get<bool>(),
+            data["voltage"].get<bool>(),
+            loadFeedforward(),
+            period * okapi::millisecond,
+            &trace
         ));
         base->startThread();
+        base->retuneBatteryCompensation(getBatteryCompensationUsage());
+        retuneSchedules();
+    }
+
+    ///Queues the current gains on the running Elliot2CCPID, see Elliot2CCPID::retuneGains().
+    void retuneGains() {
+        base->retuneGains(loadGains("dist"), loadGains("angle"), loadGains("turn"));
+    }
+
+    /**
+     * Queues the current gain schedules on the running Elliot2CCPID, see
+     * Elliot2CCPID::retuneSchedules(). Base gains are queued too, so a
+     * controller whose schedule was emptied goes back to them.
+     */
+    void retuneSchedules() {
+        base->retuneSchedules(loadSchedule("dist"), loadSchedule("angle"), loadSchedule("turn"));
+        retuneGains();
+    }
+
+    /**
+     * Gets the trace of the base's control loop. It outlives every
+     * Elliot2CCPID loadState() makes, so one task may keep popping it
+     * while the base is rebuilt, see TraceRing.
+     */
+    TraceRing& getTrace() {
+        return trace;
+    }
+
+    /**
+     * Gets the rows of a gain schedule, for editing. Changes should be
+     * followed by saveState() & retuneSchedules().
+     * 
+     * @param name Name of the schedule, "dist", "angle", or "turn"
+     */
+    json& getSchedule(const char* name) {
+        return data["schedule"][name];
+    }
+
+    ///Queues the current TrueSpeed curve on the running Elliot2CCPID.
+    void retuneTrueSpeed() {
+        base->retuneTrueSpeed(TrueSpeedTable(getTrueSpeedData(), getTrueSpeedSmoothing()));
     }
 
     /**
      * Modifies a single set of PID gains by name.
-     * This will create a new Elliot2CCPID instance and change SD card data.
+     * This will retune the running Elliot2CCPID and change SD card data.
      * @param name     Name of PID gain set, one of "dist", "angle", or "turn"
      * @param newGains New PID values
      */
@@ -93,7 +209,7 @@ class BaseSettings {
         data[name]["kP"] = newGains.kP;
         data[name]["kI"] = newGains.kI;
         data[name]["kD"] = newGains.kD;
-        loadState(); // Load new values
+        retuneGains(); // Load new values
         saveState(); // Save to SD card
     }
 
@@ -157,6 +273,37 @@ class BaseSettings {
         modGains("turn", newGains);
     }
 
+    /**
+     * Sets a PID's derivative filter & integral options. Integral options
+     * are retuned on the running Elliot2CCPID. The derivative filter is set
+     * when the PID is constructed, so changing it constructs a new one.
+     * This will modify data at getState()["base"]["pidOpts"]["<name>"].
+     * 
+     * @param name Name of the PID, "dist", "angle", or "turn"
+     * @param opts New options
+     * @see PIDOptions
+     */
+    void setPIDOptions(const char* name, const PIDOptions& opts) {
+        const bool rebuild = loadPIDOptions(name).filterDiffers(opts);
+        data["pidOpts"][name] = {
+            {"filter", derivativeFilterNames()[(int)opts.filter]},
+            {"alpha", opts.alpha},
+            {"iLimit", opts.integralLimit},
+            {"iBand", opts.integralBand},
+            {"iReset", opts.integralReset}
+        };
+        saveState();
+        if(rebuild) {
+            loadState();
+        } else {
+            base->retunePIDOptions(loadPIDOptions("dist"), loadPIDOptions("angle"), loadPIDOptions("turn"));
+        }
+    }
+
+    PIDOptions getPIDOptions(const char* name) {
+        return loadPIDOptions(name);
+    }
+
     /**
      * Sets whether or not the base should use voltage for PID.
      * This will modify data at getState["base"]["voltage"].
@@ -166,20 +313,78 @@ class BaseSettings {
     void setVoltagePIDUsage(bool useVoltage) {
         data["voltage"] = useVoltage;
         saveState();
-        loadState();
+        base->retuneVoltagePID(useVoltage);
     }
 
     bool getVoltagePIDUsage() {
         return data["voltage"].get<bool>();
     }
 
+    /**
+     * Sets whether voltage output should be scaled by the filtered battery voltage.
+     * This will modify data at getState()["base"]["batteryComp"].
+     * 
+     * @param compensate Whether to compensate for battery voltage
+     * @see getBatteryCompensation
+     */
+    void setBatteryCompensationUsage(bool compensate) {
+        data["batteryComp"] = compensate;
+        saveState();
+        base->retuneBatteryCompensation(compensate);
+    }
+
+    bool getBatteryCompensationUsage() {
+        return data["batteryComp"].get<bool>();
+    }
+
+    /**
+     * Sets the rule the relay autotuner derives gains with.
+     * This will modify data at getState()["base"]["tuneRule"].
+     * 
+     * @param rule Rule to derive gains with
+     * @see gainsFromRule
+     */
+    void setTuningRule(TuningRule rule) {
+        data["tuneRule"] = tuningRuleNames()[(int)rule];
+        saveState();
+    }
+
+    TuningRule getTuningRule() {
+        auto &names = tuningRuleNames();
+        auto found = std::find(names.begin(), names.end(), data["tuneRule"].get<std::string>());
+        return found == names.end() ? TuningRule::SOME_OVERSHOOT : (TuningRule)(found - names.begin());
+    }
+
+    /**
+     * Sets the feedforward used in voltage mode, retuning the running Elliot2CCPID.
+     * This will modify data at getState()["base"]["ff"].
+     * 
+     * @param ff New feedforward constants & profile limits
+     * @see Feedforward
+     */
+    void setFeedforward(const Feedforward& ff) {
+        data["ff"] = {
+            {"kS", ff.kS},
+            {"kV", ff.kV},
+            {"kA", ff.kA},
+            {"maxVel", ff.maxVelocity},
+            {"maxAccel", ff.maxAcceleration}
+        };
+        saveState();
+        base->retuneFeedforward(ff);
+    }
+
+    Feedforward getFeedforward() {
+        return loadFeedforward();
+    }
+
     void setTrueSpeedData(const std::vector<TrueSpeedPoint>& points) {
         auto& truespeed = data["truespeed"] = json::array({});
         for(auto& pt: points) {
             truespeed.push_back(json::array({pt.x, pt.y}));
         }
         saveState();
-        loadState();
+        retuneTrueSpeed();
     }
 
     std::vector<TrueSpeedPoint> getTrueSpeedData() {
@@ -194,11 +399,44 @@ class BaseSettings {
         return ret;
     }
 
+    /**
+     * Sets whether the TrueSpeed curve should be smoothed with a monotone
+     * cubic spline. This will modify data at getState()["base"]["tsSmooth"].
+     * 
+     * @param smooth Whether to smooth the TrueSpeed curve
+     * @see TrueSpeedTable
+     */
+    void setTrueSpeedSmoothing(bool smooth) {
+        data["tsSmooth"] = smooth;
+        saveState();
+        retuneTrueSpeed();
+    }
+
+    bool getTrueSpeedSmoothing() {
+        return data["tsSmooth"].get<bool>();
+    }
+
+    /**
+     * Sets the time between iterations of the base's control loop.
+     * This will modify data at getState()["base"]["period"].
+     * 
+     * @param periodMs Loop period in milliseconds, clamped to [minTelemetryPeriod, maxTelemetryPeriod]
+     */
+    void setLoopPeriod(int periodMs) {
+        data["period"] = std::clamp(periodMs, (int)minTelemetryPeriod, (int)maxTelemetryPeriod);
+        saveState();
+        loadState();
+    }
+
+    int getLoopPeriod() {
+        return data["period"].get<int>();
+    }
+
     void deleteTrueSpeedData() {
         if(data.find("truespeed") != data.end())
             data.erase("truespeed");
         saveState();
-        loadState();
+        retuneTrueSpeed();
     }
 
     /**
@@ -207,16 +445,20 @@ class BaseSettings {
      * 
      * @param ileft      Left MotorGroup of base
      * @param iright     Right MotorGroup of base
+     * @param ileftEnc   Encoder measuring the left side of the base
+     * @param irightEnc  Encoder measuring the right side of the base
      * @param iCPIGetter Function returning the current CPI ([encoder] counts per inch) value
      * @param iCPRGetter Function returning the current CPR ([encoder] counts per radian) value
      * @param ibase      unique_ptr& where new Elliot2CCPID instances should be written to
      * @param data       JSON object where settings should be stored
      */
     BaseSettings(MotorGroup& ileft, MotorGroup& iright, 
+    std::shared_ptr<ContinuousRotarySensor> ileftEnc,
+    std::shared_ptr<ContinuousRotarySensor> irightEnc,
     std::function<double()> iCPIGetter,
     std::function<double()> iCPRGetter,
     std::unique_ptr<Elliot2CCPID> & ibase, json& settingsLocation):
-    base(ibase), left(ileft), right(iright), cpiGetter(iCPIGetter), cprGetter(iCPRGetter), data(settingsLocation) {
+    base(ibase), left(ileft), right(iright), leftEncoder(ileftEnc), rightEncoder(irightEnc), cpiGetter(iCPIGetter), cprGetter(iCPRGetter), data(settingsLocation) {
         loadState();
     }
 };
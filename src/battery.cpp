@@ -0,0 +1,56 @@
+/**
+ * @file battery.cpp
+ *
+ * This file defines battery voltage compensation, which keeps open-loop
+ * and voltage-PID output consistent as the battery drains.
+ */
+
+#include "main.h"
+#include "battery.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+///Time between battery samples, in ms.
+const uint32_t batterySamplePeriod = 20;
+///Time constant of the low-pass filter, in seconds. Long enough to ride out the sag of a single acceleration.
+const double batteryFilterTau = 1.0;
+
+///Filtered battery voltage in mV. Only the daemon writes this.
+static std::atomic<float> filteredVoltage{(float)nominalBatteryVoltage};
+///Remaining charge in percent. Only the daemon writes this.
+static std::atomic<float> capacity{100};
+
+static void batteryDaemon(void*) {
+  uint32_t lastTime = pros::millis();
+  bool first = true;
+  const double alpha = 1 - std::exp(-(batterySamplePeriod / 1000.0) / batteryFilterTau);
+  while(true) {
+    double sample = pros::battery::get_voltage();
+    //PROS reports errors as PROS_ERR, and a disconnected battery as 0.
+    if(sample > 0 && sample != PROS_ERR) {
+      double filtered = first ? sample : filteredVoltage.load() + alpha * (sample - filteredVoltage.load());
+      filteredVoltage.store(filtered);
+      first = false;
+    }
+    const double charge = pros::battery::get_capacity();
+    if(std::isfinite(charge) && charge != PROS_ERR_F) capacity.store(charge);
+    pros::c::task_delay_until(&lastTime, batterySamplePeriod);
+  }
+}
+
+void beginBatteryTask() {
+  pros::Task daemon(batteryDaemon);
+}
+
+double getBatteryVoltage() {
+  return filteredVoltage.load();
+}
+
+double getBatteryCapacity() {
+  return capacity.load();
+}
+
+double getBatteryCompensation() {
+  return std::clamp(nominalBatteryVoltage / getBatteryVoltage(), 0.8, 1.25);
+}
@@ -0,0 +1,31 @@
+/**
+ * @file battery.hpp
+ *
+ * This file declares battery voltage compensation, which keeps open-loop
+ * and voltage-PID output consistent as the battery drains.
+ */
+
+#pragma once
+
+///Battery voltage that voltage outputs are tuned against, in mV.
+const double nominalBatteryVoltage = 12000;
+
+/**
+ * Starts the daemon that samples & low-pass filters the battery voltage.
+ * Should be called once, from Elliot::beginTasks().
+ */
+void beginBatteryTask();
+
+///Gets the filtered battery voltage, in mV. Until the first sample, this is nominalBatteryVoltage.
+double getBatteryVoltage();
+
+///Gets the battery's remaining charge, in percent, as of the last sample.
+double getBatteryCapacity();
+
+/**
+ * Gets the factor voltage outputs should be multiplied by, so the motors
+ * see the voltage they would at nominalBatteryVoltage. Motors scale
+ * commanded voltage by the real battery voltage, so this is
+ * nominalBatteryVoltage / getBatteryVoltage(), limited to [0.8, 1.25].
+ */
+double getBatteryCompensation();
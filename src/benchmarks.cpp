@@ -0,0 +1,338 @@
+/**
+ * @file benchmarks.cpp
+ *
+ * This file defines on-brain benchmarks for the math that runs in Elliot's
+ * background loops, and for the base's closed-loop moves.
+ */
+
+#include "main.h"
+#include "gps.hpp"
+#include "benchmarks.hpp"
+#include "ccpid_mod.hpp"
+#include "elliot.hpp"
+#include "jobs.hpp"
+#include "battery.hpp"
+#include "state.hpp"
+#include <cmath>
+#include <iterator>
+
+//---------------------------------------
+//  Odometry Benchmark
+//---------------------------------------
+
+///Odometry integrator under test, see arcIntegrate().
+using Integrator = void(*)(RoboPosition&, double, double, double);
+
+///A synthetic motion, giving forward speed (in/s) & heading (rad, CCW) at time t.
+///Headings are worked out by hand from the turn rate each motion is named for.
+struct OdomScenario {
+  const char* name;
+  double duration;
+  double (*speed)(double t);
+  double (*heading)(double t);
+};
+
+static const OdomScenario odomScenarios[] = {
+  //40 in/s, no turning
+  {"straight", 3.0, [](double t) { return 40.0; }, [](double t) { return 0.0; }},
+  //30 in/s, turning at 1 rad/s
+  {"arc"     , 3.0, [](double t) { return 30.0; }, [](double t) { return t; }},
+  //30 in/s, turning at 1.5 sin(2 pi t / 3) rad/s
+  {"s-curve" , 3.0, [](double t) { return 30.0; }, [](double t) { return 1.5 * 3.0 / (2 * PI) * (1 - cos(2 * PI * t / 3.0)); }},
+  //Turning in place at 3 rad/s
+  {"spin"    , 2.0, [](double t) { return 0.0; }, [](double t) { return 3 * t; }}
+};
+
+static const struct {
+  const char* name;
+  Integrator integrate;
+} odomIntegrators[] = {
+  {"arc"     , arcIntegrate     },
+  {"midpoint", midpointIntegrate}
+};
+
+///Sample periods, in ms, that the integrators are fed at.
+static const int odomSamplePeriods[] = {5, 10, 20, 50};
+
+///Resolution of the encoder feed & the ground truth's quadrature, in seconds.
+static const double odomTruthStep = 0.0005;
+
+/**
+ * Runs a scenario through an integrator, returning the final position &
+ * heading error against the ground truth. The truth's heading is the
+ * scenario's closed form, and its position is Simpson's rule over
+ * v (cos, sin) of that heading, so it owes nothing to either integrator.
+ */
+static void runOdomScenario(const OdomScenario& scenario, Integrator integrate, int periodMs,
+double cpr, double cpi, double& posError, double& headingError) {
+  RoboPosition truth = {0, 0, 0};
+  RoboPosition estimate = {0, 0, 0};
+  //Encoder counts accumulated since the last sample
+  double pendingL = 0, pendingR = 0;
+  const int substeps = std::lround((periodMs / 1000.0) / odomTruthStep);
+  const int samples = std::lround(scenario.duration * 1000 / periodMs);
+  double t = 0;
+  for(int i = 0; i < samples; i++) {
+    for(int j = 0; j < substeps; j++) {
+      //Speed & heading at the start, middle & end of this step.
+      double travel[3], heading[3];
+      for(int k = 0; k < 3; k++) {
+        travel[k] = scenario.speed(t + k * odomTruthStep / 2) * cpi;
+        heading[k] = scenario.heading(t + k * odomTruthStep / 2);
+      }
+      //Wheel travel in counts, from Simpson's rule. (R - L) / 2 is cpr counts per radian.
+      double center = odomTruthStep / 6 * (travel[0] + 4 * travel[1] + travel[2]);
+      double diff = (heading[2] - heading[0]) * cpr;
+      double L = center - diff, R = center + diff;
+      //Simpson's rule again for the truth's position.
+      truth.x += odomTruthStep / 6 * (travel[0] * cos(heading[0]) + 4 * travel[1] * cos(heading[1]) + travel[2] * cos(heading[2]));
+      truth.y += odomTruthStep / 6 * (travel[0] * sin(heading[0]) + 4 * travel[1] * sin(heading[1]) + travel[2] * sin(heading[2]));
+      pendingL += L;
+      pendingR += R;
+      t += odomTruthStep;
+    }
+    integrate(estimate, pendingL, pendingR, cpr);
+    pendingL = pendingR = 0;
+  }
+  truth.o = scenario.heading(t);
+  posError = std::hypot(estimate.x - truth.x, estimate.y - truth.y) / cpi;
+  headingError = std::abs(periodicallyEfficient(estimate.o - truth.o)) * (180.0 / PI);
+}
+
+/**
+ * Measures the time an integrator takes per update, in nanoseconds.
+ * PROS only has a millisecond timer, so this runs enough updates for the
+ * total to be well above the timer's resolution.
+ */
+static double odomNsPerUpdate(Integrator integrate, double cpr) {
+  const int updates = 20000;
+  RoboPosition pose = {0, 0, 0};
+  auto start = pros::millis();
+  for(int i = 0; i < updates; i++) {
+    integrate(pose, 10 + (i & 7), 12 - (i & 3), cpr);
+  }
+  auto elapsed = pros::millis() - start;
+  //Keep the loop from being optimized out.
+  volatile double sink = pose.x + pose.y + pose.o;
+  (void)sink;
+  return elapsed * 1e6 / updates;
+}
+
+void odometryBenchmark(double cpr, double cpi) {
+  printf("Odometry benchmark (cpr %f, cpi %f)\n", cpr, cpi);
+  printf("%-9s %-9s %6s %12s %12s\n", "scenario", "method", "dT(ms)", "pos err(in)", "hdg err(deg)");
+  for(auto &scenario: odomScenarios) {
+    for(auto &method: odomIntegrators) {
+      for(int period: odomSamplePeriods) {
+        double posError, headingError;
+        runOdomScenario(scenario, method.integrate, period, cpr, cpi, posError, headingError);
+        printf("%-9s %-9s %6d %12.6f %12.6f\n", scenario.name, method.name, period, posError, headingError);
+      }
+      pros::delay(1);
+    }
+  }
+  for(auto &method: odomIntegrators) {
+    printf("%-9s %8.1f ns/update\n", method.name, odomNsPerUpdate(method.integrate, cpr));
+  }
+}
+
+//---------------------------------------
+//  TrueSpeed Benchmark
+//---------------------------------------
+
+/**
+ * Measures the time a TrueSpeed lookup takes, in nanoseconds, over
+ * velocities sweeping [-1, 1].
+ */
+template <typename F>
+static double tsNsPerLookup(F lookup) {
+  const int lookups = 20000;
+  double sum = 0;
+  auto start = pros::millis();
+  for(int i = 0; i < lookups; i++) {
+    sum += lookup((i % 201 - 100) / 100.0);
+  }
+  auto elapsed = pros::millis() - start;
+  //Keep the loop from being optimized out.
+  volatile double sink = sum;
+  (void)sink;
+  return elapsed * 1e6 / lookups;
+}
+
+void trueSpeedBenchmark() {
+  printf("TrueSpeed benchmark\n");
+  printf("%6s %10s %10s %10s %10s\n", "points", "scan(ns)", "table(ns)", "smooth(ns)", "max diff");
+  for(int n: {2, 4, 8, 16, 32, 64}) {
+    //A curve shaped like real TrueSpeed data: a deadband, then a slight bend.
+    std::vector<TrueSpeedPoint> curve = {{0, 0}};
+    for(int i = 1; i < n; i++) {
+      double x = i / (double)(n - 1);
+      curve.push_back({x, 0.08 + 0.92 * std::pow(x, 0.85)});
+    }
+    TrueSpeedTable table(curve);
+    TrueSpeedTable smoothTable(curve, true);
+    double maxDiff = 0;
+    for(int i = 0; i <= 1000; i++) {
+      double x = i / 1000.0;
+      maxDiff = std::max(maxDiff, std::abs(table(x) - interpolate(curve, x)));
+    }
+    printf("%6d %10.1f %10.1f %10.1f %10.6f\n", n,
+      tsNsPerLookup([&curve](double x) { return interpolate(curve, x); }),
+      tsNsPerLookup([&table](double x) { return table(x); }),
+      tsNsPerLookup([&smoothTable](double x) { return smoothTable(x); }),
+      maxDiff
+    );
+    pros::delay(1);
+  }
+}
+
+//---------------------------------------
+//  Closed-loop Move Benchmark
+//---------------------------------------
+
+///Where move benchmark results are appended.
+static const char* moveHistoryPath = "/usd/movebench.csv";
+///Where the gain sets named in the results are appended.
+static const char* moveGainsPath = "/usd/movebench_gains.txt";
+///Longest a benchmark move may take to settle, in ms.
+static const uint32_t moveTimeout = 5000;
+///Pause between benchmark moves, in ms.
+static const uint32_t movePause = 300;
+
+///Settings that make up a gain set.
+static const char* gainSetFields[] = {"dist", "angle", "turn", "ff", "schedule", "voltage", "truespeed", "tsSmooth", "batteryComp", "period"};
+
+///Gets the parts of getBaseState() that make up the gain set.
+static json gainSet() {
+  auto &base = getState()["base"];
+  json ret = json::object();
+  for(auto field: gainSetFields) {
+    auto found = base.find(field);
+    if(found != base.end()) ret[field] = *found;
+  }
+  return ret;
+}
+
+std::string gainSetKey() {
+  char buf[9];
+  snprintf(buf, sizeof(buf), "%08x", (unsigned)std::hash<std::string>()(gainSet().dump()));
+  return buf;
+}
+
+/**
+ * Runs one benchmark move and measures it.
+ *
+ * @param turn   Whether to turn rather than drive straight
+ * @param amount Inches to drive or degrees to turn clockwise, may be negative
+ * @param result Where to write the measurements
+ * @return Whether the move wasn't aborted
+ */
+static bool runBenchmarkMove(bool turn, double amount, MoveResult& result) {
+  auto &bot = getRobot();
+  auto &base = *bot.base;
+  //Motor degrees per inch or degree, the same scales Elliot2CCPID uses.
+  const double scale = turn ? bot.gps.radiansToCounts(PI / 180.0) : bot.gps.inchToCounts(1);
+  auto measure = [&]() {
+    const double l = bot.left.getPosition(), r = bot.right.getPosition();
+    return (turn ? (l - r) / 2 : (l + r) / 2) / scale;
+  };
+  char name[16];
+  snprintf(name, sizeof(name), "%+.0f%s", amount, turn ? "deg" : "in");
+  result = {name, false, 0, 0, 0, 0, 0};
+
+  const double start = measure();
+  const uint32_t period = std::max<uint32_t>(1, base.getLoopPeriod().convert(millisecond));
+  if(turn) {
+    base.turnAngleAsync(amount * okapi::degree);
+  } else {
+    base.moveDistanceAsync(amount * okapi::inch);
+  }
+  const uint32_t begin = pros::millis();
+  uint32_t now = begin, rise10 = 0, rise90 = 0;
+  double furthest = 0;
+  bool aborted = false;
+  while(true) {
+    if(jobCancelled()) {
+      aborted = true;
+      break;
+    }
+    const uint32_t elapsed = pros::millis() - begin;
+    //Progress along the move, positive towards the target.
+    const double progress = (measure() - start) * (amount < 0 ? -1 : 1);
+    const double target = std::abs(amount);
+    furthest = std::max(furthest, progress);
+    if(!rise10 && progress >= 0.1 * target) rise10 = elapsed;
+    if(!rise90 && progress >= 0.9 * target) rise90 = elapsed;
+    result.peakCurrent = std::max({result.peakCurrent, std::abs(bot.left.getCurrentDraw()), std::abs(bot.right.getCurrentDraw())});
+    if(base.isSettled() || elapsed >= moveTimeout) {
+      result.settled = base.isSettled();
+      result.settleTime = elapsed;
+      result.steadyStateError = target - progress;
+      break;
+    }
+    pros::c::task_delay_until(&now, period);
+  }
+  base.stop();
+  result.riseTime = rise90 > rise10 ? rise90 - rise10 : 0;
+  result.overshoot = std::max(furthest - std::abs(amount), 0.0) / std::abs(amount) * 100;
+  jobDelay(movePause);
+  return !aborted;
+}
+
+bool moveBenchmark(std::vector<MoveResult>& results) {
+  auto &bot = getRobot();
+  bot.base->stop();
+  const std::string key = gainSetKey();
+  const double battery = getBatteryVoltage();
+  results.clear();
+  //Each move is followed by its reverse, so the robot ends where it started.
+  const struct { bool turn; double amount; } moves[] = {
+    {false, 12}, {false, 24}, {false, 48},
+    {true, 45}, {true, 90}, {true, 180}
+  };
+  bool finished = true;
+  for(auto &move: moves) {
+    for(double direction: {1.0, -1.0}) {
+      MoveResult result;
+      jobProgress("Move " + std::to_string(results.size() + 1) + "/" + std::to_string(2 * std::size(moves)));
+      if(!runBenchmarkMove(move.turn, direction * move.amount, result)) {
+        finished = false;
+        break;
+      }
+      results.push_back(result);
+    }
+    if(!finished) break;
+  }
+
+  printf("Move benchmark, gain set %s, battery %.0fmV\n", key.c_str(), battery);
+  printf("%-8s %7s %9s %8s %10s %9s %8s\n", "move", "settled", "settle(ms)", "rise(ms)", "overshoot%", "ss error", "peak(mA)");
+  for(auto &r: results) {
+    printf("%-8s %7s %9u %8u %10.2f %9.3f %8d\n", r.name.c_str(), r.settled ? "yes" : "no",
+      (unsigned)r.settleTime, (unsigned)r.riseTime, r.overshoot, r.steadyStateError, (int)r.peakCurrent);
+  }
+
+  //Only complete runs go in the history, so runs can be compared move by move.
+  if(!finished) return false;
+  //Append to the history. A missing SD card just means no history.
+  FILE *history = fopen(moveHistoryPath, "a");
+  if(history) {
+    if(ftell(history) == 0) {
+      fprintf(history, "gainset,lifetime,battery,move,settled,settle_ms,rise_ms,overshoot_pct,ss_error,peak_ma\n");
+    }
+    const double lifetime = getState()["lifetime"].get<double>() + pros::millis();
+    for(auto &r: results) {
+      fprintf(history, "%s,%.0f,%.0f,%s,%d,%u,%u,%.3f,%.4f,%d\n", key.c_str(), lifetime, battery,
+        r.name.c_str(), r.settled ? 1 : 0, (unsigned)r.settleTime, (unsigned)r.riseTime,
+        r.overshoot, r.steadyStateError, (int)r.peakCurrent);
+    }
+    fclose(history);
+  } else {
+    printf("Couldn't open %s, results weren't saved.\n", moveHistoryPath);
+  }
+  FILE *gains = fopen(moveGainsPath, "a");
+  if(gains) {
+    fprintf(gains, "%s %s\n", key.c_str(), gainSet().dump().c_str());
+    fclose(gains);
+  }
+  return true;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file benchmarks.hpp
+ *
+ * This file declares on-brain benchmarks for the math that runs in Elliot's
+ * background loops, and for the base's closed-loop moves. Results are
+ * printed to the terminal, so any change can be judged on numbers.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Feeds synthetic encoder streams (straight lines, arcs, S-curves and spins)
+ * through the odometry integrators at several sample rates, and prints the
+ * position & heading error against ground truth, plus the time per update.
+ *
+ * @param cpr Encoder counts per radian of robot rotation
+ * @param cpi Encoder counts per inch of robot travel
+ */
+void odometryBenchmark(double cpr, double cpi);
+
+/**
+ * Times TrueSpeed lookups through the old linear scan, interpolate(), against
+ * the compiled TrueSpeedTable, for synthetic curves of 2 to 64 points. Also
+ * prints how far the table strays from the scan.
+ */
+void trueSpeedBenchmark();
+
+///How one closed-loop benchmark move went.
+struct MoveResult {
+  ///Name of the move, like "+24in" or "-90deg".
+  std::string name;
+  ///Whether the base settled before the move timed out.
+  bool settled;
+  ///Time to settle, in ms.
+  uint32_t settleTime;
+  ///Time to go from 10% to 90% of the target, in ms.
+  uint32_t riseTime;
+  ///Furthest past the target the base went, as a percentage of the target.
+  double overshoot;
+  ///Distance from the target once settled, in inches or degrees.
+  double steadyStateError;
+  ///Highest current drawn by either side, in mA.
+  int32_t peakCurrent;
+};
+
+/**
+ * Runs a fixed battery of closed-loop moves on the base: 12, 24 and 48 in
+ * straights and 45, 90 and 180 degree turns, each forwards then back. Each
+ * move's settle time, rise time, overshoot, steady-state error & peak
+ * current are appended to /usd/movebench.csv, keyed by a hash of the base's
+ * gain set. The gain set itself is appended to /usd/movebench_gains.txt.
+ *
+ * Cancelling the job running it (see runJob()) aborts the run.
+ *
+ * @param results Where to write the results of each move
+ * @return Whether every move was run
+ */
+bool moveBenchmark(std::vector<MoveResult>& results);
+
+/**
+ * Gets a short key identifying the base's current gain set. Any change to
+ * gains, schedules, feedforward or TrueSpeed data changes the key.
+ */
+std::string gainSetKey();
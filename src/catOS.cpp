@@ -1,6 +1,7 @@
 #include "catOS.hpp"
 #include "elliot.hpp"
 #include "editors.hpp"
+#include <cstring>
 
 void ControllerTask::operator()() {
   render();
@@ -11,17 +12,67 @@ void ControllerTask::operator()() {
     result = checkTemporaryExit();
     if(result == ControllerTask::CheckResult::RERENDER) render();
     if(result == ControllerTask::CheckResult::GO_UP   ) break;
-    pros::delay(5);
+    menuInput().wait(menuWaitTimeout);
+  }
+}
+
+/**
+ * Screen buffer for the controller. line_set() writes the text it wants
+ * into \ref wanted, and the flush task sends lines that differ from
+ * \ref shown, one per controller slot. Both are guarded by screenLock.
+ */
+static char wanted[3][lineWidth + 1];
+///Text last sent to each line successfully. Only the flush task writes this.
+static char shown[3][lineWidth + 1];
+///When each line of \ref wanted last changed, so the newest change is sent first.
+static uint32_t changedAt[3];
+///Counts changes to \ref wanted, for \ref changedAt.
+static uint32_t changeCount = 0;
+static pros::Mutex screenLock;
+
+/**
+ * Sends changed lines to the controller, newest change first, at most one
+ * per controller slot. A line the controller rejects is retried next slot.
+ */
+static void screenFlushTask(void*) {
+  char text[lineWidth + 1];
+  while(true) {
+    int line = -1;
+    screenLock.take(TIMEOUT_MAX);
+    for(int i = 0; i < 3; i++) {
+      if(std::strcmp(wanted[i], shown[i]) && (line == -1 || changedAt[i] > changedAt[line])) line = i;
+    }
+    if(line != -1) std::strcpy(text, wanted[line]);
+    screenLock.give();
+    if(line == -1) {
+      //Nothing to send. Check back soon, so the next change goes out quickly.
+      pros::delay(10);
+      continue;
+    }
+    if(getRobot().controller.set_text(line, 0, text) == 1) {
+      std::strcpy(shown[line], text);
+    }
+    pros::delay(controllerSlot + 2);
   }
 }
 
 void line_set(int line, std::string str) {
-  if(15 >= str.size())
-    str.insert(str.end(), 15 - str.size(), ' ');
+  if(lineWidth >= str.size())
+    str.insert(str.end(), lineWidth - str.size(), ' ');
   else
-    str.erase(str.begin() + 15, str.end());
-  getRobot().controller.set_text(line, 0, str.c_str());
-  pros::delay(52);
+    str.erase(str.begin() + lineWidth, str.end());
+  static bool flushing = false;
+  screenLock.take(TIMEOUT_MAX);
+  if(!flushing) {
+    //shown starts empty, which never matches padded text, so the first frame is sent in full.
+    pros::Task flush(screenFlushTask, nullptr, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "Controller screen");
+    flushing = true;
+  }
+  if(std::strcmp(wanted[line], str.c_str())) {
+    std::strcpy(wanted[line], str.c_str());
+    changedAt[line] = ++changeCount;
+  }
+  screenLock.give();
 }
 
 void ControllerMenu::render() {
@@ -34,30 +85,47 @@ void ControllerMenu::render() {
   }
 }
 
+/**
+ * Reads a joystick axis as a direction in [-3, 3], reporting a held
+ * joystick at most once per joystickRepeat ms. Rendering used to block for
+ * about that long, which is what paced scrolling with the joystick.
+ *
+ * @param axis     Joystick axis to read
+ * @param lastTime Time this axis last reported a direction
+ */
+static int joystickDirection(pros::controller_analog_e_t axis, uint32_t& lastTime) {
+  const uint32_t joystickRepeat = 150;
+  int dir = 4 * menuInput().analog(axis)/127.0;
+  dir = std::clamp(dir, -3, 3);
+  if(!dir || pros::millis() - lastTime < joystickRepeat) return 0;
+  lastTime = pros::millis();
+  return dir;
+}
+
 int getVerticalDirection(int flip) {
-  auto &ctrl = getRobot().controller;
-  int dir = (!!ctrl.get_digital_new_press(DIGITAL_UP) - !!ctrl.get_digital_new_press(DIGITAL_DOWN));
+  static uint32_t lastTime = 0;
+  auto &ctrl = menuInput();
+  int dir = (!!ctrl.newPressOrRepeat(DIGITAL_UP) - !!ctrl.newPressOrRepeat(DIGITAL_DOWN));
   if(!dir) {
-    dir = 4 * ctrl.get_analog(ANALOG_LEFT_Y)/127.0;
-    dir = std::clamp(dir, -3, 3);
+    dir = joystickDirection(ANALOG_LEFT_Y, lastTime);
   }
   return dir * flip;
 }
 
 int getHorizontalDirection(int flip) {
-  auto &ctrl = getRobot().controller;
-  int dir = (!!ctrl.get_digital_new_press(DIGITAL_RIGHT) - !!ctrl.get_digital_new_press(DIGITAL_LEFT));
+  static uint32_t lastTime = 0;
+  auto &ctrl = menuInput();
+  int dir = (!!ctrl.newPressOrRepeat(DIGITAL_RIGHT) - !!ctrl.newPressOrRepeat(DIGITAL_LEFT));
   if(!dir) {
-    dir = 4 * ctrl.get_analog(ANALOG_LEFT_X)/127.0;
-    dir = std::clamp(dir, -3, 3);
+    dir = joystickDirection(ANALOG_LEFT_X, lastTime);
   }
   return dir * flip;
 }
 
 int ControllerMenu::checkController() {
-  auto &ctrl = getRobot().controller;
-  if(ctrl.get_digital_new_press(DIGITAL_B)) return GO_UP;
-  if(ctrl.get_digital_new_press(DIGITAL_A)) {
+  auto &ctrl = menuInput();
+  if(ctrl.newPress(DIGITAL_B)) return GO_UP;
+  if(ctrl.newPress(DIGITAL_A)) {
     list[index].second();
     return RERENDER;
   }
@@ -155,8 +223,8 @@ void CRUDMenu::render() {
 }
 
 int CRUDMenu::checkController() {
-  auto &ctrl = getRobot().controller;
-  if(ctrl.get_digital_new_press(DIGITAL_B)) {
+  auto &ctrl = menuInput();
+  if(ctrl.newPress(DIGITAL_B)) {
     if(selectedVector == ITEM_NAME_LIST) {
       finalizeData();
       return GO_UP;
@@ -165,11 +233,11 @@ int CRUDMenu::checkController() {
       return RERENDER;
     }
   };
-  if(ctrl.get_digital_new_press(DIGITAL_X)) {
+  if(ctrl.newPress(DIGITAL_X)) {
     selectedVector = CRUD_OPTION_LIST;
     return RERENDER;
   }
-  if(ctrl.get_digital_new_press(DIGITAL_A)) {
+  if(ctrl.newPress(DIGITAL_A)) {
     if(selectedVector == CRUD_OPTION_LIST) {
       crudOptions[crudIndex].second();
     } else {
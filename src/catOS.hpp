@@ -8,9 +8,15 @@
 #pragma once
 #include "main.h"
 #include "display.hpp"
+#include "input.hpp"
 #include <memory>
 #include <functional>
 
+///Characters in a controller line.
+const int lineWidth = 15;
+///Shortest time between two controller screen updates, in ms.
+const uint32_t controllerSlot = 50;
+
 /**
  * This class is the parent class of all controller menus,
  * providing a standard way to re-render menus and check
@@ -328,9 +334,10 @@ ControllerTask::CheckResult checkTemporaryExit();
  * 
  * This uses both the up/down keys and the left joystick to report
  * vertical direction. If up is pressed, this will return 1, and if
- * down is pressed, this will return -1. If neither key is pressed,
+ * down is pressed, this will return -1. Holding a key repeats it,
+ * faster the longer it's held. If neither key is pressed,
  * this will return the vertical joystick position in the integer
- * range [-3, 3].
+ * range [-3, 3]. Keys are read from menuInput().
  * 
  * @param flip Multiplies output before returning
  * @return The vertical direction from the controller
@@ -342,9 +349,10 @@ int getVerticalDirection(int flip = 1);
  * 
  * This uses both the up/down keys and the left joystick to report
  * horizontal direction. If up is pressed, this will return 1, and if
- * down is pressed, this will return -1. If neither key is pressed,
+ * down is pressed, this will return -1. Holding a key repeats it,
+ * faster the longer it's held. If neither key is pressed,
  * this will return the horizontal joystick position in the integer
- * range [-3, 3].
+ * range [-3, 3]. Keys are read from menuInput().
  * 
  * @param flip Multiplies output before returning
  * @return The horizontal direction from the controller
@@ -354,10 +362,12 @@ int getHorizontalDirection(int flip = 1);
 /**
  * @brief Sets a line on the controller.
  * 
- * This will call set_text on the controller, with trailing spaces
- * to clear previous text. It will also wait 52ms to make sure the
- * change occurred, as controller updates cannot occur more often
- * than every 50ms. 
+ * This writes the text, with trailing spaces to clear previous text,
+ * into a screen buffer and returns immediately. A background task sends
+ * lines that changed to the controller, as controller updates cannot
+ * occur more often than every 50ms. It sends one line per update, the
+ * most recently changed first, so a line set back to what's already
+ * shown costs nothing.
  * 
  * @param line Line number, from 0 to 2.
  * @param str  Text to display
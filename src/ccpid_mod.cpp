@@ -15,7 +15,15 @@
  */
 #include "ccpid_mod.hpp"
 #include "okapi/api/util/mathUtil.hpp"
+#include "debugging.hpp"
+#include "battery.hpp"
+#include "telemetry.hpp"
+#include "okapi/api/filter/averageFilter.hpp"
+#include "okapi/api/filter/demaFilter.hpp"
+#include "okapi/api/filter/emaFilter.hpp"
+#include "okapi/api/filter/medianFilter.hpp"
 #include <cmath>
+#include <limits>
 
 double interpolate(const std::vector<TrueSpeedPoint>& data, double x) {
   bool negate = x < 0 ? x*=-1, true : false;
@@ -25,7 +33,7 @@ double interpolate(const std::vector<TrueSpeedPoint>& data, double x) {
   if(data[0].x > x) {
     //This case shouldn't occur.
     bestLinearApproximationIndex = 0;
-  } else if(data[data.size()].x < x) {
+  } else if(data[data.size() - 1].x < x) {
     bestLinearApproximationIndex = data.size() - 2;
   } else {
     //Search for pair of points containing our x
@@ -47,9 +55,78 @@ double interpolate(const std::vector<TrueSpeedPoint>& data, double x) {
   return y;
 }
 
+/**
+ * Evaluates a monotone cubic (Fritsch-Carlson) spline through a TrueSpeed
+ * curve at x. Outside of the curve's points, this falls back to the same
+ * linear extrapolation as interpolate().
+ * 
+ * @param data     TrueSpeed points, sorted by x
+ * @param tangents Tangent at each point, see monotoneTangents()
+ * @param x        Velocity in [0, 1]
+ */
+static double monotoneCubic(const std::vector<TrueSpeedPoint>& data, const std::vector<double>& tangents, double x) {
+  for(int i = 0; i < data.size() - 1; i++) {
+    double h = data[i + 1].x - data[i].x;
+    if(data[i].x <= x && x <= data[i + 1].x && h > 0) {
+      double t = (x - data[i].x) / h;
+      double t2 = t * t, t3 = t2 * t;
+      return (2*t3 - 3*t2 + 1) * data[i].y + (t3 - 2*t2 + t) * h * tangents[i] +
+             (-2*t3 + 3*t2) * data[i + 1].y + (t3 - t2) * h * tangents[i + 1];
+    }
+  }
+  return interpolate(data, x);
+}
+
+/**
+ * Computes Fritsch-Carlson tangents for a TrueSpeed curve, which keep a
+ * cubic spline through the curve from overshooting between points.
+ */
+static std::vector<double> monotoneTangents(const std::vector<TrueSpeedPoint>& data) {
+  const int n = data.size();
+  std::vector<double> secants(n - 1), tangents(n);
+  for(int i = 0; i < n - 1; i++) {
+    double h = data[i + 1].x - data[i].x;
+    secants[i] = h > 0 ? (data[i + 1].y - data[i].y) / h : 0;
+  }
+  tangents[0] = secants[0];
+  tangents[n - 1] = secants[n - 2];
+  for(int i = 1; i < n - 1; i++) {
+    //Flat at local extrema, average of the secants elsewhere
+    tangents[i] = secants[i - 1] * secants[i] <= 0 ? 0 : (secants[i - 1] + secants[i]) / 2;
+  }
+  for(int i = 0; i < n - 1; i++) {
+    if(secants[i] == 0) {
+      tangents[i] = tangents[i + 1] = 0;
+      continue;
+    }
+    double a = tangents[i] / secants[i];
+    double b = tangents[i + 1] / secants[i];
+    //Scale tangents back into the region that guarantees monotonicity
+    if(a*a + b*b > 9) {
+      double tau = 3 / std::sqrt(a*a + b*b);
+      tangents[i] = tau * a * secants[i];
+      tangents[i + 1] = tau * b * secants[i];
+    }
+  }
+  return tangents;
+}
+
+TrueSpeedTable::TrueSpeedTable(const std::vector<TrueSpeedPoint>& points, bool smooth) {
+  std::vector<TrueSpeedPoint> data = points;
+  //A curve needs two points to interpolate between. Fall back to the identity.
+  if(data.size() < 2) data = {{0, 0}, {1, 1}};
+  std::vector<double> tangents;
+  if(smooth) tangents = monotoneTangents(data);
+  for(int i = 0; i < size; i++) {
+    double x = i / (double)(size - 1);
+    table[i] = smooth ? monotoneCubic(data, tangents, x) : interpolate(data, x);
+  }
+  table[size] = table[size - 1];
+}
+
 void driveVectorVoltage(const okapi::ChassisModel& model,
-const std::vector<TrueSpeedPoint>& trueSpeedData,
-double iforwardSpeed, double iyaw) {
+const TrueSpeedTable& trueSpeed,
+double iforwardSpeed, double iyaw, double batteryScale) {
   // This code is taken from WPIlib. All credit goes to them. Link:
   // https://github.com/wpilibsuite/allwpilib/blob/master/wpilibc/src/main/native/cpp/Drive/DifferentialDrive.cpp#L73
   const double forwardSpeed = std::clamp(iforwardSpeed, -1.0, 1.0);
@@ -62,36 +139,162 @@ double iforwardSpeed, double iyaw) {
     leftOutput /= maxInputMag;
     rightOutput /= maxInputMag;
   }
-  model.tank(interpolate(trueSpeedData, leftOutput), interpolate(trueSpeedData, rightOutput));
+  model.tank(std::clamp(trueSpeed(leftOutput) * batteryScale, -1.0, 1.0),
+             std::clamp(trueSpeed(rightOutput) * batteryScale, -1.0, 1.0));
 }
 
 void rotateVoltage(const okapi::ChassisModel& model,
-const std::vector<TrueSpeedPoint>& trueSpeedData,
-double ispeed) {
+const TrueSpeedTable& trueSpeed,
+double ispeed, double batteryScale) {
   const double speed = std::clamp(ispeed, -1.0, 1.0);
-  model.tank(interpolate(trueSpeedData, speed), interpolate(trueSpeedData, -1 * speed));
+  const double output = std::clamp(trueSpeed(speed) * batteryScale, -1.0, 1.0);
+  model.tank(output, -output);
+}
+
+/**
+ * Drives each side at its own voltage, through the TrueSpeed curve.
+ * 
+ * @param ileftSpeed left side speed, in [-1, 1]
+ * @param irightSpeed right side speed, in [-1, 1]
+ */
+static void tankVoltage(const okapi::ChassisModel& model,
+const TrueSpeedTable& trueSpeed,
+double ileftSpeed, double irightSpeed, double batteryScale) {
+  const double left = std::clamp(trueSpeed(std::clamp(ileftSpeed, -1.0, 1.0)) * batteryScale, -1.0, 1.0);
+  const double right = std::clamp(trueSpeed(std::clamp(irightSpeed, -1.0, 1.0)) * batteryScale, -1.0, 1.0);
+  model.tank(left, right);
+}
+
+const std::vector<std::string>& derivativeFilterNames() {
+  static const std::vector<std::string> names = {
+    "None", "EMA", "DEMA", "Median", "Average"
+  };
+  return names;
+}
+
+std::unique_ptr<okapi::Filter> PIDOptions::makeFilter() const {
+  const double weight = std::clamp(alpha, 0.01, 1.0);
+  switch(filter) {
+    case DerivativeFilter::EMA:     return std::make_unique<okapi::EmaFilter>(weight);
+    case DerivativeFilter::DEMA:    return std::make_unique<okapi::DemaFilter>(weight, weight);
+    case DerivativeFilter::MEDIAN:  return std::make_unique<okapi::MedianFilter<5>>();
+    case DerivativeFilter::AVERAGE: return std::make_unique<okapi::AverageFilter<5>>();
+    default:                        return std::make_unique<okapi::PassthroughFilter>();
+  }
+}
+
+void PIDOptions::applyTo(okapi::IterativePosPIDController& controller) const {
+  const double limit = std::abs(integralLimit);
+  controller.setIntegralLimits(limit, -limit);
+  controller.setErrorSumLimits(integralBand > 0 ? integralBand : std::numeric_limits<double>::max(), 0);
+  controller.setIntegratorReset(integralReset);
+}
+
+TrapezoidProfile::TrapezoidProfile(double idistance, double maxVelocity, double maxAcceleration):
+direction(idistance < 0 ? -1 : 1), distance(std::abs(idistance)), acceleration(maxAcceleration) {
+  if(distance * maxAcceleration < maxVelocity * maxVelocity) {
+    //Triangular, the profile has to slow down before it reaches maxVelocity
+    peakVelocity = std::sqrt(distance * maxAcceleration);
+    accelTime = peakVelocity / maxAcceleration;
+    cruiseTime = 0;
+  } else {
+    peakVelocity = maxVelocity;
+    accelTime = maxVelocity / maxAcceleration;
+    cruiseTime = (distance - maxVelocity * accelTime) / maxVelocity;
+  }
+}
+
+void TrapezoidProfile::sample(double t, double& pos, double& vel, double& acc) const {
+  const double accelDist = 0.5 * acceleration * accelTime * accelTime;
+  if(t <= 0) {
+    pos = vel = acc = 0;
+  } else if(t < accelTime) {
+    pos = 0.5 * acceleration * t * t;
+    vel = acceleration * t;
+    acc = acceleration;
+  } else if(t < accelTime + cruiseTime) {
+    pos = accelDist + peakVelocity * (t - accelTime);
+    vel = peakVelocity;
+    acc = 0;
+  } else if(t < getDuration()) {
+    const double td = t - accelTime - cruiseTime;
+    pos = accelDist + peakVelocity * cruiseTime + peakVelocity * td - 0.5 * acceleration * td * td;
+    vel = peakVelocity - acceleration * td;
+    acc = -acceleration;
+  } else {
+    pos = distance;
+    vel = acc = 0;
+  }
+  pos *= direction;
+  vel *= direction;
+  acc *= direction;
+}
+
+double TrapezoidProfile::getDuration() const {
+  return 2 * accelTime + cruiseTime;
+}
+
+GainSchedule::GainSchedule(const std::vector<Row>& irows) {
+  count = std::min<int>(irows.size(), maxRows);
+  std::copy(irows.begin(), irows.begin() + count, rows.begin());
+  std::sort(rows.begin(), rows.begin() + count, [](const Row& a, const Row& b) {
+    return a.magnitude < b.magnitude;
+  });
+}
+
+okapi::IterativePosPIDController::Gains GainSchedule::operator()(double magnitude) const {
+  magnitude = std::abs(magnitude);
+  if(count == 0) return {0, 0, 0, 0};
+  if(magnitude <= rows[0].magnitude) return rows[0].gains;
+  for(int i = 0; i < count - 1; i++) {
+    auto &lo = rows[i], &hi = rows[i + 1];
+    if(magnitude <= hi.magnitude) {
+      double t = hi.magnitude > lo.magnitude ? (magnitude - lo.magnitude) / (hi.magnitude - lo.magnitude) : 1;
+      return {
+        lo.gains.kP + (hi.gains.kP - lo.gains.kP) * t,
+        lo.gains.kI + (hi.gains.kI - lo.gains.kI) * t,
+        lo.gains.kD + (hi.gains.kD - lo.gains.kD) * t,
+        lo.gains.kBias + (hi.gains.kBias - lo.gains.kBias) * t
+      };
+    }
+  }
+  return rows[count - 1].gains;
+}
+
+///Sets a controller's gains from a Gains struct.
+static void setGains(okapi::IterativePosPIDController& controller, const okapi::IterativePosPIDController::Gains& gains) {
+  controller.setGains(gains.kP, gains.kI, gains.kD, gains.kBias);
 }
 
 namespace okapi {
 Elliot2CCPID::Elliot2CCPID(
   const TimeUtil &itimeUtil,
-  const std::shared_ptr<ChassisModel> &imodel,
+  const std::shared_ptr<Elliot2SkidSteerModel> &imodel,
   std::unique_ptr<IterativePosPIDController> idistanceController,
   std::unique_ptr<IterativePosPIDController> iangleController,
   std::unique_ptr<IterativePosPIDController> iturnController,
   const AbstractMotor::GearsetRatioPair igearset,
   const ChassisScales &iscales,
   const std::vector<TrueSpeedPoint>& trueSpeedData,
-  bool voltagePIDOn)
+  bool trueSpeedSmoothing,
+  bool voltagePIDOn,
+  const Feedforward &ifeedforward,
+  QTime iloopPeriod,
+  TraceRing *itrace)
   : ChassisController(imodel, toUnderlyingType(igearset.internalGearset)),
     timeUtil(itimeUtil),
+    skidModel(imodel),
     distancePid(std::move(idistanceController)),
     anglePid(std::move(iangleController)),
     turnPid(std::move(iturnController)),
     scales(iscales),
     gearsetRatioPair(igearset),
-    tsd(trueSpeedData),
-    useVoltagePID(voltagePIDOn) {
+    threadSleepTime(iloopPeriod),
+    trace(itrace),
+    tsd(trueSpeedData, trueSpeedSmoothing),
+    useVoltagePID(voltagePIDOn),
+    feedforward(ifeedforward),
+    pendingTsd(tsd) {
   if (igearset.ratio == 0) {
     logger->error("Elliot2CCPID: The gear ratio cannot be zero! Check if you are using "
                   "integer division.");
@@ -99,6 +302,11 @@ Elliot2CCPID::Elliot2CCPID(
                                 "are using integer division.");
   }
 
+  //The PIDs only produce new output once per sample time, so it must match the loop.
+  distancePid->setSampleTime(iloopPeriod);
+  anglePid->setSampleTime(iloopPeriod);
+  turnPid->setSampleTime(iloopPeriod);
+
   setGearing(igearset.internalGearset);
   setEncoderUnits(AbstractMotor::encoderUnits::degrees);
 }
@@ -107,14 +315,22 @@ Elliot2CCPID::Elliot2CCPID(Elliot2CCPID &&other) noexcept
   : ChassisController(other.model, other.maxVelocity, other.maxVoltage),
     logger(other.logger),
     timeUtil(other.timeUtil),
+    skidModel(other.skidModel),
     distancePid(std::move(other.distancePid)),
     anglePid(std::move(other.anglePid)),
     turnPid(std::move(other.turnPid)),
     scales(other.scales),
     gearsetRatioPair(other.gearsetRatioPair),
+    trace(other.trace),
+    tsd(other.tsd),
+    useVoltagePID(other.useVoltagePID),
+    compensateBattery(other.compensateBattery),
+    feedforward(other.feedforward),
+    pendingTsd(other.pendingTsd),
     doneLooping(other.doneLooping.load(std::memory_order_acquire)),
     newMovement(other.newMovement.load(std::memory_order_acquire)),
     dtorCalled(other.dtorCalled.load(std::memory_order_acquire)),
+    threadSleepTime(other.threadSleepTime),
     mode(other.mode),
     task(other.task) {
   other.task = nullptr;
@@ -122,17 +338,61 @@ Elliot2CCPID::Elliot2CCPID(Elliot2CCPID &&other) noexcept
 
 Elliot2CCPID::~Elliot2CCPID() {
   dtorCalled.store(true, std::memory_order_release);
+  if (task) {
+    //Deleting the task outright would leave it subscribed to telemetry, so let it unsubscribe first.
+    if (auto loop = loopTask.load(std::memory_order_acquire)) {
+      pros::c::task_notify(loop);
+    }
+    while (!loopExited.load(std::memory_order_acquire)) {
+      pros::delay(1);
+    }
+  }
   delete task;
 }
 
 void Elliot2CCPID::loop() {
-  auto encStartVals = model->getSensorVals();
-  std::valarray<std::int32_t> encVals;
+  //Sensor values are read into fixed arrays, so nothing here touches the heap.
+  std::array<std::int32_t, 2> encStartVals, encVals;
+  skidModel->getSensorVals(encStartVals);
   double distanceElapsed = 0, angleChange = 0;
   modeType pastMode = none;
-  auto rate = timeUtil.getRate();
+  auto timer = timeUtil.getTimer();
+  QTime profileStart = 0_ms;
+  const std::uint32_t period = threadSleepTime.convert(millisecond);
+  std::uint32_t lastTickStart = timer->millis().convert(millisecond);
+  bool firstTick = true;
+  //Full motor speed, in motor degrees per second, to trace PID outputs as velocities.
+  const double outputToVelocity = toUnderlyingType(gearsetRatioPair.internalGearset) * 6.0;
+  //Position traced last iteration, to trace the measured velocity.
+  double lastTraced = 0;
+  //Read for the base's current draw when tracing, rather than asking the motors every tick.
+  TelemetrySnapshot snapshot;
+  //Count this task's allocations from here on, to show the steady-state loop makes none.
+  watchAllocations();
+  //Encoders read from the DriveMonitor, which only changes once per telemetry tick, so run right after each one.
+  const pros::task_t self = pros::c::task_get_current();
+  loopTask.store(self, std::memory_order_release);
+  const bool subscribed = subscribeTelemetry(self);
+  if (!subscribed) {
+    printf("Elliot2CCPID: couldn't subscribe to telemetry, falling back to a timed loop\n");
+  }
 
   while (!dtorCalled.load(std::memory_order_acquire)) {
+    if (!subscribed) {
+      pros::delay(period);
+    } else if (!pros::c::task_notify_take(true, period * 2)) {
+      //A missed tick leaves nothing new to act on, but dtorCalled still has to be checked.
+      continue;
+    }
+    if (dtorCalled.load(std::memory_order_acquire)) {
+      break;
+    }
+    const std::uint32_t tickStart = timer->millis().convert(millisecond);
+    //Jitter is how far the time since the last iteration strays from the period.
+    const std::uint32_t interval = tickStart - lastTickStart;
+    const std::uint32_t jitter = firstTick ? 0 : (interval > period ? interval - period : period - interval);
+    lastTickStart = tickStart;
+    firstTick = false;
     /**
      * doneLooping is set to false by moveDistanceAsync and turnAngleAsync and then set to true by
      * waitUntilSettled
@@ -141,41 +401,267 @@ void Elliot2CCPID::loop() {
       doneLoopingSeen.store(true, std::memory_order_release);
     } else {
       if (mode != pastMode || newMovement.load(std::memory_order_acquire)) {
-        encStartVals = model->getSensorVals();
+        skidModel->getSensorVals(encStartVals);
         newMovement.store(false, std::memory_order_release);
+        lastTraced = 0;
+        profile = TrapezoidProfile(profileGoal, feedforward.maxVelocity, feedforward.maxAcceleration);
+        profileStart = timer->millis();
+        //Swap in the gains scheduled for this movement's size.
+        if (mode == distance || mode == arcing) {
+          if (!distanceSchedule.empty()) ::setGains(*distancePid, distanceSchedule(scheduleKey));
+          if (!angleSchedule.empty()) ::setGains(*anglePid, angleSchedule(scheduleKey));
+        } else if ((mode == angle || mode == swinging) && !turnSchedule.empty()) {
+          ::setGains(*turnPid, turnSchedule(scheduleKey));
+        }
       }
 
+      //Position, velocity & acceleration the profile wants right now.
+      const bool useFeedforward = useVoltagePID && feedforward.enabled();
+      double profilePos = 0, profileVel = 0, profileAcc = 0;
+      if (useFeedforward) {
+        const double t = (timer->millis() - profileStart).convert(second);
+        profile.sample(t, profilePos, profileVel, profileAcc);
+        profileDone.store(t >= profile.getDuration(), std::memory_order_release);
+      } else {
+        profileDone.store(true, std::memory_order_release);
+      }
+      const double feedforwardOut = feedforward(profileVel, profileAcc) / maxVoltage;
+      const double batteryScale = compensateBattery ? getBatteryCompensation() : 1.0;
+
       switch (mode) {
       case distance:
-        encVals = model->getSensorVals() - encStartVals;
+      case arcing: {
+        skidModel->getSensorVals(encVals);
+        encVals[0] -= encStartVals[0];
+        encVals[1] -= encStartVals[1];
         distanceElapsed = static_cast<double>((encVals[0] + encVals[1])) / 2.0;
         angleChange = static_cast<double>(encVals[0] - encVals[1]);
-        if(useVoltagePID) {
-          driveVectorVoltage(*model, tsd, distancePid->step(distanceElapsed), anglePid->step(angleChange));
+        /**
+         * An arc is a straight drive whose heading should change in step with
+         * distance, so the angle PID corrects around that instead of around 0.
+         * Each side also gets its share of the forward output, (1 +- curve),
+         * so the angle PID only has to correct.
+         */
+        const double curve = mode == arcing ? arcRatio / 2 : 0;
+        if (mode == arcing) angleChange -= arcRatio * distanceElapsed;
+        if(useFeedforward) {
+          distancePid->setTarget(profilePos);
+          const double forward = distancePid->step(distanceElapsed);
+          const double yaw = anglePid->step(angleChange);
+          const double left = feedforward(profileVel * (1 + curve), profileAcc * (1 + curve)) / maxVoltage + forward * (1 + curve) + yaw;
+          const double right = feedforward(profileVel * (1 - curve), profileAcc * (1 - curve)) / maxVoltage + forward * (1 - curve) - yaw;
+          model->tank(std::clamp(left * batteryScale, -1.0, 1.0), std::clamp(right * batteryScale, -1.0, 1.0));
+        } else if(useVoltagePID) {
+          const double forward = distancePid->step(distanceElapsed);
+          driveVectorVoltage(*model, tsd, forward, forward * curve + anglePid->step(angleChange), batteryScale);
         } else {
-          model->driveVector(distancePid->step(distanceElapsed), anglePid->step(angleChange));
+          const double forward = distancePid->step(distanceElapsed);
+          model->driveVector(forward, forward * curve + anglePid->step(angleChange));
         }
         break;
+      }
 
       case angle:
-        encVals = model->getSensorVals() - encStartVals;
+        skidModel->getSensorVals(encVals);
+        encVals[0] -= encStartVals[0];
+        encVals[1] -= encStartVals[1];
         angleChange = (encVals[0] - encVals[1]) / 2.0;
-        if(useVoltagePID) {
-          rotateVoltage(*model, tsd, turnPid->step(angleChange));
+        if(useFeedforward) {
+          turnPid->setTarget(profilePos);
+          const double speed = std::clamp((feedforwardOut + turnPid->step(angleChange)) * batteryScale, -1.0, 1.0);
+          model->tank(speed, -speed);
+        } else if(useVoltagePID) {
+          rotateVoltage(*model, tsd, turnPid->step(angleChange), batteryScale);
         } else {
           model->rotate(turnPid->step(angleChange));
         }
         break;
 
+      case swinging: {
+        skidModel->getSensorVals(encVals);
+        encVals[0] -= encStartVals[0];
+        encVals[1] -= encStartVals[1];
+        //Measured like a turn in place, since the locked side should barely move.
+        angleChange = (encVals[0] - encVals[1]) / 2.0;
+        //The angle PID holds the locked side at 0, the turn PID drives the other.
+        const double hold = anglePid->step(swingLockLeft ? encVals[0] : encVals[1]);
+        double turn;
+        if(useFeedforward) {
+          //The free side covers the whole turn alone, so twice the profile's speed.
+          turnPid->setTarget(profilePos);
+          turn = feedforward(profileVel * 2, profileAcc * 2) / maxVoltage + turnPid->step(angleChange);
+        } else {
+          turn = turnPid->step(angleChange);
+        }
+        const double left = swingLockLeft ? hold : turn;
+        const double right = swingLockLeft ? -turn : hold;
+        if(useFeedforward) {
+          model->tank(std::clamp(left * batteryScale, -1.0, 1.0), std::clamp(right * batteryScale, -1.0, 1.0));
+        } else if(useVoltagePID) {
+          tankVoltage(*model, tsd, left, right, batteryScale);
+        } else {
+          model->left(left);
+          model->right(right);
+        }
+        break;
+      }
+
       default:
         break;
       }
 
+      if (mode != none && trace) {
+        //Trace the PID driving the movement, along the direction it drives.
+        const bool turning = mode == angle || mode == swinging;
+        const auto &pid = turning ? *turnPid : *distancePid;
+        const double traced = turning ? angleChange : distanceElapsed;
+        TraceSample sample;
+        sample.time = tickStart;
+        sample.error = pid.getError();
+        sample.commanded = useFeedforward ? profileVel : pid.getOutput() * outputToVelocity;
+        sample.actual = interval ? (traced - lastTraced) * 1000.0 / interval : 0;
+        getTelemetry(snapshot);
+        sample.current = (snapshot.leftCurrent + snapshot.rightCurrent) / 2.0;
+        trace->push(sample);
+        lastTraced = traced;
+      }
+
       pastMode = mode;
     }
 
-    rate->delayUntil(threadSleepTime);
+    applyRetune();
+
+    //Record timing statistics. Only this loop writes them, so plain stores are enough.
+    const std::uint32_t execTime = timer->millis().convert(millisecond) - tickStart;
+    loopStats.ticks.store(loopStats.ticks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    loopStats.execTime.store(execTime, std::memory_order_relaxed);
+    loopStats.jitter.store(jitter, std::memory_order_relaxed);
+    if (execTime > loopStats.maxExecTime.load(std::memory_order_relaxed)) {
+      loopStats.maxExecTime.store(execTime, std::memory_order_relaxed);
+    }
+    if (jitter > loopStats.maxJitter.load(std::memory_order_relaxed)) {
+      loopStats.maxJitter.store(jitter, std::memory_order_relaxed);
+    }
+    if (execTime > period) {
+      loopStats.overruns.store(loopStats.overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    //Only this task touches the PIDs, so the dashboard reads their state through telemetry.
+    publishBaseStatus({getError(), isSettled(), jitter, loopStats.maxJitter.load(std::memory_order_relaxed),
+                       loopStats.overruns.load(std::memory_order_relaxed)});
+  }
+  unsubscribeTelemetry(self);
+  //The destructor deletes this task, so it mustn't return and delete itself as well.
+  loopExited.store(true, std::memory_order_release);
+  while (true) {
+    pros::c::task_notify_take(true, TIMEOUT_MAX);
+  }
+}
+
+void Elliot2CCPID::applyRetune() {
+  if (!retunePending.load(std::memory_order_acquire)) {
+    return;
+  }
+  retuneLock.take(TIMEOUT_MAX);
+  if (pending.schedules) {
+    distanceSchedule = pending.distanceSchedule;
+    angleSchedule = pending.angleSchedule;
+    turnSchedule = pending.turnSchedule;
+  }
+  if (pending.gains) {
+    //setGains() keeps each controller's target, error & integral, so the movement continues.
+    //Controllers with a schedule keep their scheduled gains.
+    if (distanceSchedule.empty()) ::setGains(*distancePid, pending.distance);
+    if (angleSchedule.empty()) ::setGains(*anglePid, pending.angle);
+    if (turnSchedule.empty()) ::setGains(*turnPid, pending.turn);
+  }
+  if (pending.trueSpeed) {
+    tsd = pendingTsd;
+  }
+  if (pending.voltage) {
+    useVoltagePID = pending.useVoltagePID;
+  }
+  if (pending.feedforward) {
+    feedforward = pending.feedforwardConstants;
   }
+  if (pending.battery) {
+    compensateBattery = pending.compensateBattery;
+  }
+  if (pending.options) {
+    pending.distanceOptions.applyTo(*distancePid);
+    pending.angleOptions.applyTo(*anglePid);
+    pending.turnOptions.applyTo(*turnPid);
+  }
+  pending.gains = pending.trueSpeed = pending.voltage = pending.feedforward = pending.schedules = pending.battery = pending.options = false;
+  retunePending.store(false, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retuneGains(const IterativePosPIDController::Gains &idistanceGains,
+                               const IterativePosPIDController::Gains &iangleGains,
+                               const IterativePosPIDController::Gains &iturnGains) {
+  retuneLock.take(TIMEOUT_MAX);
+  pending.distance = idistanceGains;
+  pending.angle = iangleGains;
+  pending.turn = iturnGains;
+  pending.gains = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retuneTrueSpeed(const TrueSpeedTable &itable) {
+  retuneLock.take(TIMEOUT_MAX);
+  pendingTsd = itable;
+  pending.trueSpeed = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retuneFeedforward(const Feedforward &ifeedforward) {
+  retuneLock.take(TIMEOUT_MAX);
+  pending.feedforwardConstants = ifeedforward;
+  pending.feedforward = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retuneSchedules(const GainSchedule &idistanceSchedule,
+                                   const GainSchedule &iangleSchedule,
+                                   const GainSchedule &iturnSchedule) {
+  retuneLock.take(TIMEOUT_MAX);
+  pending.distanceSchedule = idistanceSchedule;
+  pending.angleSchedule = iangleSchedule;
+  pending.turnSchedule = iturnSchedule;
+  pending.schedules = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retuneBatteryCompensation(bool icompensateBattery) {
+  retuneLock.take(TIMEOUT_MAX);
+  pending.compensateBattery = icompensateBattery;
+  pending.battery = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retunePIDOptions(const PIDOptions &idistanceOptions,
+                                    const PIDOptions &iangleOptions,
+                                    const PIDOptions &iturnOptions) {
+  retuneLock.take(TIMEOUT_MAX);
+  pending.distanceOptions = idistanceOptions;
+  pending.angleOptions = iangleOptions;
+  pending.turnOptions = iturnOptions;
+  pending.options = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
+}
+
+void Elliot2CCPID::retuneVoltagePID(bool voltagePIDOn) {
+  retuneLock.take(TIMEOUT_MAX);
+  pending.useVoltagePID = voltagePIDOn;
+  pending.voltage = true;
+  retunePending.store(true, std::memory_order_release);
+  retuneLock.give();
 }
 
 void Elliot2CCPID::trampoline(void *context) {
@@ -201,6 +687,9 @@ void Elliot2CCPID::moveDistanceAsync(const QLength itarget) {
 
   distancePid->setTarget(newTarget);
   anglePid->setTarget(0);
+  profileGoal = newTarget;
+  scheduleKey = itarget.convert(inch);
+  profileDone.store(false, std::memory_order_release);
 
   doneLooping.store(false, std::memory_order_release);
   newMovement.store(true, std::memory_order_release);
@@ -237,6 +726,9 @@ void Elliot2CCPID::turnAngleAsync(const QAngle idegTarget) {
   logger->info("Elliot2CCPID: turning " + std::to_string(newTarget) + " motor degrees");
 
   turnPid->setTarget(newTarget);
+  profileGoal = newTarget;
+  scheduleKey = idegTarget.convert(degree);
+  profileDone.store(false, std::memory_order_release);
 
   doneLooping.store(false, std::memory_order_release);
   newMovement.store(true, std::memory_order_release);
@@ -257,6 +749,79 @@ void Elliot2CCPID::turnAngle(const double idegTarget) {
   turnAngle((idegTarget / scales.turn) * degree);
 }
 
+void Elliot2CCPID::arcAsync(const QLength iradius, const QAngle iangle) {
+  logger->info("Elliot2CCPID: arcing " + std::to_string(iangle.convert(degree)) +
+               " degrees with radius " + std::to_string(iradius.convert(meter)) + " meters");
+
+  //The radius alone says which way to drive, so a counterclockwise arc still goes forwards.
+  const QLength length = iradius * std::abs(iangle.convert(radian));
+  const double distanceTarget = length.convert(meter) * scales.straight * gearsetRatioPair.ratio;
+  //(left - right) / 2 at the end of the arc, the same as turnAngleAsync's target.
+  const double turnTarget =
+    iangle.convert(degree) * scales.turn * gearsetRatioPair.ratio * boolToSign(normalTurns);
+  if (distanceTarget == 0) {
+    //Without a radius, the heading can't follow distance, so turn in place.
+    turnAngleAsync(iangle);
+    return;
+  }
+
+  distancePid->reset();
+  anglePid->reset();
+  distancePid->flipDisable(false);
+  anglePid->flipDisable(false);
+  turnPid->flipDisable(true);
+  mode = arcing;
+
+  logger->info("Elliot2CCPID: arcing " + std::to_string(distanceTarget) + " motor degrees");
+
+  distancePid->setTarget(distanceTarget);
+  anglePid->setTarget(0);
+  arcRatio = 2 * turnTarget / distanceTarget;
+  profileGoal = distanceTarget;
+  scheduleKey = length.convert(inch);
+  profileDone.store(false, std::memory_order_release);
+
+  doneLooping.store(false, std::memory_order_release);
+  newMovement.store(true, std::memory_order_release);
+}
+
+void Elliot2CCPID::arc(const QLength iradius, const QAngle iangle) {
+  arcAsync(iradius, iangle);
+  waitUntilSettled();
+}
+
+void Elliot2CCPID::swingAsync(const QAngle idegTarget, const bool ilockLeft) {
+  logger->info("Elliot2CCPID: swinging " + std::to_string(idegTarget.convert(degree)) +
+               " degrees about the " + (ilockLeft ? "left" : "right") + " side");
+
+  turnPid->reset();
+  anglePid->reset();
+  turnPid->flipDisable(false);
+  anglePid->flipDisable(false);
+  distancePid->flipDisable(true);
+  mode = swinging;
+
+  const double newTarget =
+    idegTarget.convert(degree) * scales.turn * gearsetRatioPair.ratio * boolToSign(normalTurns);
+
+  logger->info("Elliot2CCPID: swinging " + std::to_string(newTarget) + " motor degrees");
+
+  turnPid->setTarget(newTarget);
+  anglePid->setTarget(0);
+  swingLockLeft = ilockLeft;
+  profileGoal = newTarget;
+  scheduleKey = idegTarget.convert(degree);
+  profileDone.store(false, std::memory_order_release);
+
+  doneLooping.store(false, std::memory_order_release);
+  newMovement.store(true, std::memory_order_release);
+}
+
+void Elliot2CCPID::swing(const QAngle idegTarget, const bool ilockLeft) {
+  swingAsync(idegTarget, ilockLeft);
+  waitUntilSettled();
+}
+
 void Elliot2CCPID::waitUntilSettled() {
   logger->info("Elliot2CCPID: Waiting to settle");
   bool completelySettled = false;
@@ -264,10 +829,12 @@ void Elliot2CCPID::waitUntilSettled() {
   while (!completelySettled) {
     switch (mode) {
     case distance:
+    case arcing:
       completelySettled = waitForDistanceSettled();
       break;
 
     case angle:
+    case swinging:
       completelySettled = waitForAngleSettled();
       break;
 
@@ -303,14 +870,18 @@ bool Elliot2CCPID::waitForDistanceSettled() {
   logger->info("Elliot2CCPID: Waiting to settle in distance mode");
 
   auto rate = timeUtil.getRate();
-  while (!(distancePid->isSettled() && anglePid->isSettled())) {
-    if (mode == angle) {
+  while (!(profileDone.load(std::memory_order_acquire) && distancePid->isSettled() && anglePid->isSettled())) {
+    if (mode == angle || mode == swinging) {
       // False will cause the loop to re-enter the switch
       logger->warn("Elliot2CCPID: Mode changed to angle while waiting in distance!");
       return false;
     }
+    // stop() from another task (e.g. a cancelled job) ends the wait.
+    if (mode == none) {
+      return true;
+    }
 
-    rate->delayUntil(10_ms);
+    rate->delayUntil(threadSleepTime);
   }
 
   // True will cause the loop to exit
@@ -326,14 +897,18 @@ bool Elliot2CCPID::waitForAngleSettled() {
   logger->info("Elliot2CCPID: Waiting to settle in angle mode");
 
   auto rate = timeUtil.getRate();
-  while (!turnPid->isSettled()) {
-    if (mode == distance) {
+  while (!(profileDone.load(std::memory_order_acquire) && turnPid->isSettled() &&
+           (mode != swinging || anglePid->isSettled()))) {
+    if (mode == distance || mode == arcing) {
       // False will cause the loop to re-enter the switch
       logger->warn("Elliot2CCPID: Mode changed to distance while waiting in angle!");
       return false;
     }
+    if (mode == none) {
+      return true;
+    }
 
-    rate->delayUntil(10_ms);
+    rate->delayUntil(threadSleepTime);
   }
 
   // True will cause the loop to exit
@@ -369,15 +944,33 @@ AbstractMotor::GearsetRatioPair Elliot2CCPID::getGearsetRatioPair() const {
 }
 
 bool Elliot2CCPID::isSettled() const {
-  if(mode == angle) {
+  if(!profileDone.load(std::memory_order_acquire)) {
+    return false;
+  } else if(mode == angle) {
     return turnPid->isSettled();
+  } else if(mode == swinging) {
+    return turnPid->isSettled() && anglePid->isSettled();
   } else {
     return anglePid->isSettled() && distancePid->isSettled();
   }
 }
 
+const LoopStats& Elliot2CCPID::getLoopStats() const {
+  return loopStats;
+}
+
+void Elliot2CCPID::resetLoopStats() {
+  loopStats.overruns.store(0, std::memory_order_relaxed);
+  loopStats.maxExecTime.store(0, std::memory_order_relaxed);
+  loopStats.maxJitter.store(0, std::memory_order_relaxed);
+}
+
+QTime Elliot2CCPID::getLoopPeriod() const {
+  return threadSleepTime;
+}
+
 double Elliot2CCPID::getError() const {
-  if(mode == angle) {
+  if(mode == angle || mode == swinging) {
     return turnPid->getError();
   } else {
     return distancePid->getError();
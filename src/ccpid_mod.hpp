@@ -16,19 +16,271 @@
 #pragma once
 
 #include "okapi/api/chassis/controller/chassisController.hpp"
+#include "okapi/api/chassis/model/skidSteerModel.hpp"
 #include "okapi/api/control/iterative/iterativePosPidController.hpp"
 #include "okapi/api/util/abstractRate.hpp"
 #include "okapi/api/util/logging.hpp"
 #include "okapi/api/util/timeUtil.hpp"
+#include "controlTrace.hpp"
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cmath>
 #include <memory>
+#include <string>
+#include <vector>
 
 struct TrueSpeedPoint {
   double x;
   double y;
 };
 
+/**
+ * Linearly interpolates a TrueSpeed curve by scanning its points. The curve
+ * is mirrored for negative x. Points must be sorted by x.
+ * 
+ * @param data TrueSpeed points, at least two
+ * @param x    Velocity to find the output for, in [-1, 1]
+ * @return Output for x, read off the curve
+ */
+double interpolate(const std::vector<TrueSpeedPoint>& data, double x);
+
+/**
+ * A TrueSpeed curve compiled into a uniformly sampled lookup table over
+ * [0, 1], so a lookup costs the same no matter how many points the curve
+ * has. Compiling can optionally smooth the curve with a monotone cubic
+ * spline, instead of connecting its points with straight lines.
+ */
+class TrueSpeedTable {
+  public:
+  ///Number of uniformly spaced samples over [0, 1].
+  static constexpr int size = 256;
+
+  /**
+   * Compiles a TrueSpeed curve into a lookup table.
+   * 
+   * @param points TrueSpeed points, sorted by x
+   * @param smooth Whether to use monotone cubic interpolation between points
+   */
+  TrueSpeedTable(const std::vector<TrueSpeedPoint>& points, bool smooth = false);
+
+  /**
+   * Looks up the output for a velocity. The curve is mirrored for negative
+   * velocities, and velocities past 1 are clamped. This doesn't branch.
+   * 
+   * @param x Velocity to find the output for, in [-1, 1]
+   */
+  double operator()(double x) const {
+    const double pos = std::min(std::abs(x), 1.0) * (size - 1);
+    const int i = static_cast<int>(pos);
+    const double y = table[i] + (table[i + 1] - table[i]) * (pos - i);
+    return std::copysign(y, x);
+  }
+
+  private:
+  ///Samples of the curve. The extra sample repeats the last one, so x = 1 needs no special case.
+  std::array<double, size + 1> table;
+};
+
+/**
+ * Characterized feedforward for one side of the base. It predicts the
+ * voltage that holds a velocity & acceleration, so PID only has to correct
+ * what the model misses:
+ * 
+ *   voltage = kS * sgn(velocity) + kV * velocity + kA * acceleration
+ * 
+ * Velocities are in motor degrees per second, accelerations in motor
+ * degrees per second squared, and voltages in millivolts. Motions are
+ * shaped by a TrapezoidProfile limited to maxVelocity & maxAcceleration.
+ */
+struct Feedforward {
+  ///Voltage to overcome static friction, in mV.
+  double kS = 0;
+  ///Voltage per unit of velocity, in mV / (deg/s).
+  double kV = 0;
+  ///Voltage per unit of acceleration, in mV / (deg/s^2).
+  double kA = 0;
+  ///Fastest velocity a profile may command, in deg/s.
+  double maxVelocity = 0;
+  ///Fastest acceleration a profile may command, in deg/s^2.
+  double maxAcceleration = 0;
+
+  ///Whether there's enough data to use feedforward at all.
+  bool enabled() const {
+    return kV > 0 && maxVelocity > 0 && maxAcceleration > 0;
+  }
+
+  ///Predicts the voltage, in mV, for a velocity & acceleration.
+  double operator()(double velocity, double acceleration) const {
+    return (velocity > 0 ? kS : velocity < 0 ? -kS : 0) + kV * velocity + kA * acceleration;
+  }
+};
+
+///Low-pass filters a PID can run its derivative through.
+enum class DerivativeFilter {
+  NONE = 0, ///< Raw encoder differences
+  EMA,      ///< Exponential moving average, weighted by alpha
+  DEMA,     ///< Double exponential moving average, weighted by alpha. Lags less than EMA.
+  MEDIAN,   ///< Median of the last 5 derivatives, which rejects single-tick spikes
+  AVERAGE   ///< Average of the last 5 derivatives
+};
+
+///Names of every DerivativeFilter, in order, for menus & settings.
+const std::vector<std::string>& derivativeFilterNames();
+
+/**
+ * Options for one of the base's PIDs, beyond its gains. The integral options
+ * can be retuned on a running Elliot2CCPID, but the derivative filter is set
+ * when the controller is constructed, so changing it needs a new one.
+ */
+struct PIDOptions {
+  ///Filter for the derivative term.
+  DerivativeFilter filter = DerivativeFilter::NONE;
+  ///Weight of the newest derivative in EMA & DEMA filters, in (0, 1]. Lower is smoother.
+  double alpha = 1;
+  ///Largest magnitude the integral term may reach, in PID output.
+  double integralLimit = 1;
+  ///Largest error, in motor degrees, that's added to the integral. 0 for no limit.
+  double integralBand = 0;
+  ///Whether to clear the integral when the error crosses 0.
+  bool integralReset = false;
+
+  ///Makes a new derivative filter of this type.
+  std::unique_ptr<okapi::Filter> makeFilter() const;
+
+  ///Applies the integral options to a controller.
+  void applyTo(okapi::IterativePosPIDController& controller) const;
+
+  ///Whether other's derivative filter differs from this one's.
+  bool filterDiffers(const PIDOptions& other) const {
+    return filter != other.filter || alpha != other.alpha;
+  }
+};
+
+/**
+ * Trapezoidal motion profile: accelerates at a constant rate, cruises, then
+ * decelerates to a stop at the target. Short moves never reach cruising
+ * speed, and become triangular instead.
+ */
+class TrapezoidProfile {
+  public:
+  ///Profile that stays at 0.
+  TrapezoidProfile() = default;
+
+  /**
+   * Plans a profile from 0 to distance.
+   * 
+   * @param distance        Distance to travel, may be negative
+   * @param maxVelocity     Speed limit, must be positive
+   * @param maxAcceleration Acceleration limit, must be positive
+   */
+  TrapezoidProfile(double distance, double maxVelocity, double maxAcceleration);
+
+  /**
+   * Samples the profile.
+   * 
+   * @param t   Seconds since the profile started
+   * @param pos Where to write the position
+   * @param vel Where to write the velocity
+   * @param acc Where to write the acceleration
+   */
+  void sample(double t, double& pos, double& vel, double& acc) const;
+
+  ///Seconds until the profile reaches its target.
+  double getDuration() const;
+
+  private:
+  double direction = 1, distance = 0;
+  double acceleration = 0, peakVelocity = 0;
+  double accelTime = 0, cruiseTime = 0;
+};
+
+/**
+ * A small table of PID gains keyed by the magnitude of a movement, in
+ * inches for driving or degrees for turning. Gains between two rows are
+ * blended linearly, and magnitudes past either end use that end's gains.
+ * Rows live in a fixed array, so copying a schedule never allocates.
+ */
+class GainSchedule {
+  public:
+  ///Most rows a schedule can hold.
+  static constexpr int maxRows = 8;
+  ///One row of the table.
+  struct Row {
+    double magnitude;
+    okapi::IterativePosPIDController::Gains gains;
+  };
+
+  ///Empty schedule, which leaves gains alone.
+  GainSchedule() = default;
+
+  /**
+   * Builds a schedule from rows in any order. Rows past maxRows are dropped.
+   * 
+   * @param rows Rows of the table
+   */
+  GainSchedule(const std::vector<Row>& rows);
+
+  ///Whether the schedule has no rows, and shouldn't be used.
+  bool empty() const {
+    return count == 0;
+  }
+
+  /**
+   * Looks up the gains for a movement.
+   * 
+   * @param magnitude Size of the movement, its sign is ignored
+   */
+  okapi::IterativePosPIDController::Gains operator()(double magnitude) const;
+
+  private:
+  std::array<Row, maxRows> rows;
+  int count = 0;
+};
+
+/**
+ * Timing statistics for the loop of an Elliot2CCPID. Only the loop writes
+ * to these, and each field is a separate atomic, so other tasks can read
+ * them at any time without locking. All times are in milliseconds.
+ */
+struct LoopStats {
+  ///Number of loop iterations run.
+  std::atomic<std::uint32_t> ticks{0};
+  ///Number of iterations that took longer than the loop period to run.
+  std::atomic<std::uint32_t> overruns{0};
+  ///Time taken by the most recent iteration.
+  std::atomic<std::uint32_t> execTime{0};
+  ///Longest time taken by any iteration.
+  std::atomic<std::uint32_t> maxExecTime{0};
+  ///How far the most recent iteration woke up from its scheduled time.
+  std::atomic<std::uint32_t> jitter{0};
+  ///Furthest any iteration woke up from its scheduled time.
+  std::atomic<std::uint32_t> maxJitter{0};
+};
+
 namespace okapi {
+/**
+ * SkidSteerModel with a sensor read path that doesn't allocate.
+ * SkidSteerModel::getSensorVals() returns a new std::valarray every call,
+ * which is too much heap traffic for a control loop that never stops.
+ */
+class Elliot2SkidSteerModel : public SkidSteerModel {
+  public:
+  using SkidSteerModel::SkidSteerModel;
+
+  /**
+   * Reads the left and right sensors into a caller-provided array.
+   *
+   * @param ovals where to write the left & right sensor values
+   */
+  void getSensorVals(std::array<std::int32_t, 2> &ovals) const {
+    ovals[0] = static_cast<std::int32_t>(leftSensor->get());
+    ovals[1] = static_cast<std::int32_t>(rightSensor->get());
+  }
+
+  using SkidSteerModel::getSensorVals;
+};
+
 class Elliot2CCPID : public virtual ChassisController {
   public:
   /**
@@ -40,16 +292,28 @@ class Elliot2CCPID : public virtual ChassisController {
    * @param iangleController angle PID controller (keeps the robot straight)
    * @param igearset motor internal gearset and gear ratio
    * @param iscales see ChassisScales docs
+   * @param trueSpeedData TrueSpeed points used in voltage mode
+   * @param trueSpeedSmoothing whether to smooth the TrueSpeed curve, see TrueSpeedTable
+   * @param voltagePIDOn whether to use voltage instead of velocity for PID output
+   * @param ifeedforward feedforward used in voltage mode, see Feedforward
+   * @param iloopPeriod time between iterations of the control loop. The loop runs once per
+   * telemetry tick, so this should equal getTelemetryPeriod().
+   * @param itrace where to trace the loop's signals, or nullptr for nowhere. It must outlive
+   * this controller, and is kept outside it so readers survive the base being rebuilt.
    */
   Elliot2CCPID(const TimeUtil &itimeUtil,
-                       const std::shared_ptr<ChassisModel> &imodel,
+                       const std::shared_ptr<Elliot2SkidSteerModel> &imodel,
                        std::unique_ptr<IterativePosPIDController> idistanceController,
                        std::unique_ptr<IterativePosPIDController> iangleController,
                        std::unique_ptr<IterativePosPIDController> iturnController,
                        AbstractMotor::GearsetRatioPair igearset,
                        const ChassisScales &iscales,
                        const std::vector<TrueSpeedPoint>& trueSpeedData,
-                       bool voltagePIDOn);
+                       bool trueSpeedSmoothing,
+                       bool voltagePIDOn,
+                       const Feedforward &ifeedforward = {},
+                       QTime iloopPeriod = 10_ms,
+                       TraceRing *itrace = nullptr);
 
   Elliot2CCPID(Elliot2CCPID &&other) noexcept;
 
@@ -111,11 +375,54 @@ class Elliot2CCPID : public virtual ChassisController {
    */
   void turnAngleAsync(double idegTarget) override;
 
+  /**
+   * @brief Drives the robot along an arc (using closed-loop control).
+   * 
+   * 7th modification to the original ChassisControllerPID. The distance
+   * PID drives the centre of the robot along the arc, while the angle PID
+   * keeps the heading turning in step with the distance travelled, rather
+   * than keeping it straight. A radius of 0 turns in place.
+   * 
+   * @param iradius radius of the arc. Negative drives backwards.
+   * @param iangle angle to turn clockwise over the arc
+   */
+  void arc(QLength iradius, QAngle iangle);
+
+  /**
+   * Sets the target arc for the robot to drive along (using closed-loop
+   * control), see arc().
+   * 
+   * @param iradius radius of the arc. Negative drives backwards.
+   * @param iangle angle to turn clockwise over the arc
+   */
+  void arcAsync(QLength iradius, QAngle iangle);
+
+  /**
+   * @brief Swing turns the robot clockwise about one side (using closed-loop control).
+   * 
+   * The turn PID drives the free side through the turn, while the angle PID
+   * holds the locked side where it started.
+   * 
+   * @param idegTarget angle to turn for
+   * @param ilockLeft true to pivot on the left side, false to pivot on the right
+   */
+  void swing(QAngle idegTarget, bool ilockLeft);
+
+  /**
+   * Sets the target angle for the robot to swing turn clockwise about one
+   * side (using closed-loop control), see swing().
+   * 
+   * @param idegTarget angle to turn for
+   * @param ilockLeft true to pivot on the left side, false to pivot on the right
+   */
+  void swingAsync(QAngle idegTarget, bool ilockLeft);
+
   /**
    * Delays until the currently executing movement completes.
    * This implementation differs slightly from the original
    * ChassisControllerPID implementation in OkapiLib, as it
-   * does not stop the PID loop once settled.
+   * does not stop the PID loop once settled, and it returns
+   * as soon as stop() is called from another task.
    */
   void waitUntilSettled() override;
 
@@ -156,9 +463,105 @@ class Elliot2CCPID : public virtual ChassisController {
    */
   double getError() const;
 
+  /**
+   * @brief Returns timing statistics for the control loop.
+   * 
+   * 4th modification to the original ChassisControllerPID, this exposes
+   * execution time, wake-up jitter, and overruns of the loop.
+   */
+  const LoopStats& getLoopStats() const;
+
+  /**
+   * Clears the maximums & overrun count in getLoopStats().
+   */
+  void resetLoopStats();
+
+  /**
+   * Returns the time between iterations of the control loop.
+   */
+  QTime getLoopPeriod() const;
+
+  /**
+   * @brief Queues new gains for the distance, angle & turn controllers.
+   * 
+   * 5th modification to the original ChassisControllerPID, this retunes
+   * the running controller. The loop swaps the gains in between
+   * iterations, so a movement in progress carries on with the new gains.
+   * 
+   * @param idistanceGains new distance PID gains
+   * @param iangleGains new angle PID gains
+   * @param iturnGains new turn PID gains
+   */
+  void retuneGains(const IterativePosPIDController::Gains &idistanceGains,
+                   const IterativePosPIDController::Gains &iangleGains,
+                   const IterativePosPIDController::Gains &iturnGains);
+
+  /**
+   * Queues a new TrueSpeed curve, swapped in by the loop between iterations.
+   * 
+   * @param itable new TrueSpeed curve
+   */
+  void retuneTrueSpeed(const TrueSpeedTable &itable);
+
+  /**
+   * Queues new feedforward constants, applied by the loop between iterations.
+   * They take effect from the next movement.
+   * 
+   * @param ifeedforward new feedforward constants
+   */
+  void retuneFeedforward(const Feedforward &ifeedforward);
+
+  /**
+   * @brief Queues new gain schedules for the distance, angle & turn controllers.
+   * 
+   * 6th modification to the original ChassisControllerPID. At the start of
+   * each movement, a controller with a non-empty schedule gets the gains
+   * scheduled for the movement's size, instead of its base gains. Distance
+   * & angle schedules are keyed in inches, turn schedules in degrees.
+   * 
+   * @param idistanceSchedule new distance gain schedule
+   * @param iangleSchedule new angle gain schedule
+   * @param iturnSchedule new turn gain schedule
+   */
+  void retuneSchedules(const GainSchedule &idistanceSchedule,
+                       const GainSchedule &iangleSchedule,
+                       const GainSchedule &iturnSchedule);
+
+  /**
+   * Queues whether voltage output should be scaled by the filtered battery
+   * voltage, see getBatteryCompensation(). Applied by the loop between
+   * iterations.
+   * 
+   * @param icompensateBattery whether to compensate for battery voltage
+   */
+  void retuneBatteryCompensation(bool icompensateBattery);
+
+  /**
+   * Queues a switch between voltage & velocity PID output, applied by the
+   * loop between iterations.
+   * 
+   * @param voltagePIDOn whether to use voltage instead of velocity for PID output
+   */
+  void retuneVoltagePID(bool voltagePIDOn);
+
+  /**
+   * Queues new integral limits, bands & reset options for each PID, applied
+   * by the loop between iterations. Each controller keeps its integral, so
+   * a movement in progress continues. Derivative filters are left alone.
+   * 
+   * @param idistanceOptions new distance PID options
+   * @param iangleOptions new angle PID options
+   * @param iturnOptions new turn PID options
+   */
+  void retunePIDOptions(const PIDOptions &idistanceOptions,
+                        const PIDOptions &iangleOptions,
+                        const PIDOptions &iturnOptions);
+
   protected:
   Logger *logger;
   TimeUtil timeUtil;
+  ///The same object as model, kept with its real type for its non-allocating sensor reads.
+  std::shared_ptr<Elliot2SkidSteerModel> skidModel;
   std::unique_ptr<IterativePosPIDController> distancePid;
   std::unique_ptr<IterativePosPIDController> anglePid;
   std::unique_ptr<IterativePosPIDController> turnPid;
@@ -168,22 +571,90 @@ class Elliot2CCPID : public virtual ChassisController {
   std::atomic_bool doneLoopingSeen{true};
   std::atomic_bool newMovement{false};
   std::atomic_bool dtorCalled{false};
+  ///The loop's task, once it has started. The destructor wakes it to see dtorCalled.
+  std::atomic<pros::task_t> loopTask{nullptr};
+  ///Set by the loop once it has unsubscribed from telemetry, and may be deleted.
+  std::atomic_bool loopExited{false};
   QTime threadSleepTime{10_ms};
-  std::vector<TrueSpeedPoint> tsd;
+  LoopStats loopStats;
+  /**
+   * @brief Where the loop traces its signals, or nullptr.
+   * 
+   * 8th modification to the original ChassisControllerPID. While a movement
+   * runs, every iteration pushes the error, the commanded & measured
+   * velocity of the active PID, and the base's current draw from telemetry.
+   * The ring belongs to whoever constructed this, see BaseSettings::getTrace().
+   */
+  TraceRing *trace;
+  TrueSpeedTable tsd;
 
   /**
    * @brief Whether to use PID with voltage or velocity.
    */
   bool useVoltagePID = false;
 
+  /**
+   * @brief Whether to scale voltage output by getBatteryCompensation().
+   */
+  bool compensateBattery = true;
+
+  /**
+   * @brief Feedforward used in voltage mode, if enabled.
+   * 
+   * When it is, movements follow a TrapezoidProfile. The PIDs track the
+   * profile's position, and their output is added to the feedforward
+   * voltage for the profile's velocity & acceleration, in place of the
+   * TrueSpeed curve.
+   */
+  Feedforward feedforward;
+  ///Profile of the current movement, only used by the loop.
+  TrapezoidProfile profile;
+  ///Target of the current movement, in motor degrees, set before newMovement.
+  double profileGoal = 0;
+  ///Whether the current movement's profile has finished. Always true without feedforward.
+  std::atomic_bool profileDone{true};
+
+  ///Gain schedules, only used by the loop, see retuneSchedules().
+  GainSchedule distanceSchedule, angleSchedule, turnSchedule;
+  ///Size of the current movement in inches or degrees, set before newMovement.
+  double scheduleKey = 0;
+  ///Change in (left - right) per motor degree travelled, while arcing. Set before newMovement.
+  double arcRatio = 0;
+  ///Which side is held still while swinging. Set before newMovement.
+  bool swingLockLeft = false;
+
+  ///Updates queued by the retune methods, guarded by retuneLock.
+  struct {
+    bool gains = false;
+    bool trueSpeed = false;
+    bool voltage = false;
+    bool feedforward = false;
+    bool schedules = false;
+    bool battery = false;
+    bool options = false;
+    IterativePosPIDController::Gains distance, angle, turn;
+    PIDOptions distanceOptions, angleOptions, turnOptions;
+    Feedforward feedforwardConstants;
+    GainSchedule distanceSchedule, angleSchedule, turnSchedule;
+    bool useVoltagePID = false;
+    bool compensateBattery = true;
+  } pending;
+  ///TrueSpeed curve queued by retuneTrueSpeed(), kept outside pending as it has no default.
+  TrueSpeedTable pendingTsd;
+  ///Set when pending holds an update, so the loop only locks when it has to.
+  std::atomic_bool retunePending{false};
+  pros::Mutex retuneLock;
+
   static void trampoline(void *context);
   void loop();
+  ///Applies any updates queued by the retune methods. Only called by the loop.
+  void applyRetune();
 
   bool waitForDistanceSettled();
   bool waitForAngleSettled();
   void stopAfterSettled();
 
-  typedef enum { distance, angle, none } modeType;
+  typedef enum { distance, angle, arcing, swinging, none } modeType;
   modeType mode{none};
 
   CrossplatformThread *task{nullptr};
@@ -0,0 +1,75 @@
+/**
+ * @file controlTrace.hpp
+ *
+ * This file declares control traces, which carry samples of a control
+ * loop's signals to the brain screen's strip charts without locking.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+///One tick of a control loop's signals.
+struct TraceSample {
+  ///Time of the tick, in ms.
+  std::uint32_t time;
+  ///PID error, in the loop's sensor units.
+  float error;
+  ///Velocity the loop commanded, in degrees per second.
+  float commanded;
+  ///Velocity measured, in degrees per second.
+  float actual;
+  ///Current drawn by the loop's motors, in mA.
+  float current;
+};
+
+/**
+ * Fixed-size single-producer, single-consumer ring of TraceSamples. The
+ * control loop pushes and the UI pops, each touching only its own index,
+ * so neither ever waits for the other. When the UI falls behind, new
+ * samples are dropped rather than overwriting ones it may be reading.
+ */
+class TraceRing {
+  public:
+  ///Room for this many samples, minus one. A power of two.
+  static constexpr std::uint32_t size = 64;
+
+  ///Adds a sample. Only call from the one loop writing this ring.
+  void push(const TraceSample& sample) {
+    const std::uint32_t h = head.load(std::memory_order_relaxed);
+    const std::uint32_t next = (h + 1) & (size - 1);
+    if(next == tail.load(std::memory_order_acquire)) {
+      dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return;
+    }
+    samples[h] = sample;
+    head.store(next, std::memory_order_release);
+  }
+
+  /**
+   * Takes the oldest sample. Only call from the one task reading this ring.
+   *
+   * @param out Where to copy the sample
+   * @return Whether there was a sample
+   */
+  bool pop(TraceSample& out) {
+    const std::uint32_t t = tail.load(std::memory_order_relaxed);
+    if(t == head.load(std::memory_order_acquire)) return false;
+    out = samples[t];
+    tail.store((t + 1) & (size - 1), std::memory_order_release);
+    return true;
+  }
+
+  ///Number of samples dropped because the ring was full.
+  std::uint32_t getDropped() const {
+    return dropped.load(std::memory_order_relaxed);
+  }
+
+  private:
+  TraceSample samples[size];
+  ///Index the next push writes. Only the producer writes this.
+  std::atomic<std::uint32_t> head{0};
+  ///Index the next pop reads. Only the consumer writes this.
+  std::atomic<std::uint32_t> tail{0};
+  std::atomic<std::uint32_t> dropped{0};
+};
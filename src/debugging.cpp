@@ -1,7 +1,44 @@
 #include "main.h"
+#include "debugging.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include <string>
 //Debug Logger - This function should not be used in production code.
 void debug(std::string text) {
   printf(text.c_str());
   pros::delay(500);
 }
+
+//Allocation Counter - Replaces the global operator new to count allocations
+//made by one watched task. This is cheap enough to leave on in production.
+static std::atomic<pros::task_t> allocationWatchedTask{nullptr};
+static std::atomic<uint32_t> allocationWatchedCount{0};
+
+static void* countedAllocation(std::size_t size) {
+  if(allocationWatchedTask.load(std::memory_order_relaxed) &&
+     allocationWatchedTask.load(std::memory_order_relaxed) == pros::c::task_get_current()) {
+    allocationWatchedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  if(!size) size = 1;
+  void* ptr = malloc(size);
+  if(!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size) {
+  return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size) {
+  return countedAllocation(size);
+}
+
+void watchAllocations() {
+  allocationWatchedCount.store(0, std::memory_order_relaxed);
+  allocationWatchedTask.store(pros::c::task_get_current(), std::memory_order_release);
+}
+
+uint32_t getWatchedAllocations() {
+  return allocationWatchedCount.load(std::memory_order_relaxed);
+}
@@ -1,3 +1,16 @@
 #pragma once
 #include <string>
+#include <cstdint>
 void debug(std::string message);
+
+/**
+ * Starts counting heap allocations made by the calling task. Only one task
+ * is watched at a time; calling this again moves the watch to the new task.
+ */
+void watchAllocations();
+
+/**
+ * Number of heap allocations the watched task has made since it called
+ * watchAllocations().
+ */
+uint32_t getWatchedAllocations();
@@ -10,7 +10,16 @@
 #include "editors.hpp"
 #include "catOS.hpp"
 #include <functional>
+#include <atomic>
+#include <map>
 #include "debugging.hpp"
+#include "benchmarks.hpp"
+#include "sysid.hpp"
+#include "autotune.hpp"
+#include "jobs.hpp"
+#include "autonEditor.hpp"
+#include "telemetry.hpp"
+#include "battery.hpp"
 using namespace okapi;
 
 //Display code! This file contains the code for:
@@ -36,6 +45,8 @@ lv_point_t origPoints[] = { {0, 0}, {30, 0}, {24, -6}, {30, 0}, {24, 6}, {30, 0}
 lv_point_t newPoints[6];
 lv_obj_t* arrow;
 lv_obj_t* orientationLabel;
+//Planned path of the selected auton, drawn under the arrow.
+lv_obj_t* previewLine;
 
 //Rotates the robot position arrow according to the robot's rotation value.
 void rotateIt(lv_point_t* points, lv_point_t* dPoints, int count, double rotation) {
@@ -56,26 +67,57 @@ void fix(lv_point_t* points, int count) {
   }
 }
 
-//Updates robot arrow on screen.
+//Pose last drawn by updateRobot(), in inches & radians. NAN until the first draw.
+double shownX = NAN, shownY = NAN, shownO = NAN;
+//How far the robot must move before updateRobot() redraws it, in inches & radians.
+const double redrawDistance = 0.25;
+const double redrawAngle = PI / 180;
+//Recent path of the robot, oldest first, at least trailSpacing inches apart.
+const int trailLength = 64;
+const double trailSpacing = 2;
+lv_point_t trailPoints[trailLength];
+int trailCount = 0;
+double trailX = NAN, trailY = NAN;
+lv_obj_t* trail;
+
+//Adds a point to the end of the trail, dropping the oldest when it's full.
+void extendTrail(double x, double y) {
+  if(std::hypot(x - trailX, y - trailY) < trailSpacing) return;
+  trailX = x;
+  trailY = y;
+  if(trailCount == trailLength) {
+    std::copy(trailPoints + 1, trailPoints + trailLength, trailPoints);
+    trailCount--;
+  }
+  trailPoints[trailCount++] = {(lv_coord_t)(x * 180.0 / 144.0), (lv_coord_t)(180 - y * 180.0 / 144.0)};
+  lv_line_set_points(trail, trailPoints, trailCount);
+}
+
+//Updates robot arrow on screen, if the robot has moved since it was last drawn.
 void updateRobot() {
   auto &gps = getRobot().gps;
   RoboPosition yeet = gps.getPosition();
-  lv_obj_set_pos(arrow, (gps.countsToInch(yeet.x) * 180.0 / 144.0)-80, 180-(gps.countsToInch(yeet.y) * 180.0 / 144.0)-80);
+  const double x = gps.countsToInch(yeet.x);
+  const double y = gps.countsToInch(yeet.y);
+  if(std::abs(x - shownX) < redrawDistance && std::abs(y - shownY) < redrawDistance && std::abs(yeet.o - shownO) < redrawAngle) {
+    return;
+  }
+  shownX = x;
+  shownY = y;
+  shownO = yeet.o;
+  extendTrail(x, y);
+  lv_obj_set_pos(arrow, (x * 180.0 / 144.0)-80, 180-(y * 180.0 / 144.0)-80);
   rotateIt(origPoints, newPoints, 6, yeet.o);
   fix(newPoints, 6);
   lv_line_set_points(arrow, newPoints, 6);
-  lv_obj_invalidate(arrow);
-  static char orientationBuffer[1024];
-  snprintf(orientationBuffer, sizeof(orientationBuffer), "x: %f\ny: %f\no: %f", gps.countsToInch(yeet.x), gps.countsToInch(yeet.y), yeet.o);
+  static char orientationBuffer[48];
+  snprintf(orientationBuffer, sizeof(orientationBuffer), "x: %.1f\ny: %.1f\no: %.1f", x, y, yeet.o * 180 / PI);
   lv_label_set_text(orientationLabel, orientationBuffer);
 }
 
-//Initializes the on-screen field.
-lv_obj_t* debugField;
-void oyes() {
-  debugField = lv_obj_create(lv_scr_act(), NULL);
-  lv_obj_set_pos(debugField, 20, 20);
-  lv_obj_set_size(debugField, 180, 180);
+//Creates a field of colored tiles, size pixels square. The field's own
+//background is the gray tiles, so only the starting tiles are objects.
+lv_obj_t* createField(lv_obj_t* parent, lv_coord_t size) {
   static lv_style_t gray;
   static lv_style_t red;
   static lv_style_t blue;
@@ -88,24 +130,45 @@ void oyes() {
   lv_style_copy(&blue, &gray);
   blue.body.main_color = LV_COLOR_HEX(0x0000FF);
   blue.body.grad_color = LV_COLOR_HEX(0x0000FF);
-  static lv_style_t* field[] = {
-    &gray, &gray, &gray, &gray, &gray, &gray, 
-    &gray, &gray, &gray, &gray, &gray, &gray, 
-    &red , &gray, &gray, &gray, &gray, &blue, 
-    &gray, &gray, &gray, &gray, &gray, &gray, 
-    &red , &gray, &gray, &gray, &gray, &blue, 
-    &gray, &gray, &gray, &gray, &gray, &gray, 
+  //Column, row & style of each starting tile.
+  static const struct { int x, y; lv_style_t* style; } tiles[] = {
+    {0, 2, &red}, {5, 2, &blue},
+    {0, 4, &red}, {5, 4, &blue},
   };
-  for(int y = 0; y < 6; y++) {
-    for(int x = 0; x < 6; x++) {
-      lv_obj_t* tile = lv_obj_create(debugField, NULL);
-      lv_obj_set_pos(tile, x * 30, y * 30);
-      lv_obj_set_size(tile, 30, 30);
-      lv_obj_set_style(tile, field[y*6 + x]);
-    }
+  lv_obj_t* field = lv_obj_create(parent, NULL);
+  lv_obj_set_size(field, size, size);
+  lv_obj_set_style(field, &gray);
+  const lv_coord_t tileSize = size / 6;
+  for(auto &tileInfo: tiles) {
+    lv_obj_t* tile = lv_obj_create(field, NULL);
+    lv_obj_set_pos(tile, tileInfo.x * tileSize, tileInfo.y * tileSize);
+    lv_obj_set_size(tile, tileSize, tileSize);
+    lv_obj_set_style(tile, tileInfo.style);
+    //Let touches through to the field.
+    lv_obj_set_click(tile, false);
   }
+  return field;
+}
+
+//Initializes the on-screen field.
+lv_obj_t* debugField;
+void oyes() {
+  debugField = createField(lv_scr_act(), 180);
+  lv_obj_set_pos(debugField, 20, 20);
   orientationLabel = lv_label_create(debugField, NULL);
   lv_label_set_text(orientationLabel, "Loading...");
+  static lv_style_t previewStyle;
+  lv_style_copy(&previewStyle, &lv_style_plain);
+  previewStyle.line.color = LV_COLOR_HEX(0xFFFF00);
+  previewStyle.line.width = 2;
+  previewLine = lv_line_create(debugField, NULL);
+  lv_line_set_style(previewLine, &previewStyle);
+  static lv_style_t trailStyle;
+  lv_style_copy(&trailStyle, &lv_style_plain);
+  trailStyle.line.color = LV_COLOR_HEX(0xFFFFFF);
+  trailStyle.line.width = 1;
+  trail = lv_line_create(debugField, NULL);
+  lv_line_set_style(trail, &trailStyle);
   arrow = lv_line_create(debugField, NULL);
   lv_obj_set_pos(arrow, 12, 108);
   lv_obj_set_style(arrow, &lv_style_plain);
@@ -128,9 +191,15 @@ void putImage() {
 //---------------------------------------
 lv_obj_t* autoSelectorObj;
 lv_obj_t* buttonTemplate;
+//Guards currentlySelected, and the preview cache below.
+pros::Mutex previewLock;
+//Written by the selector's buttons on LVGL's task, read from any task.
 std::string currentlySelected = "#No Auton";
 std::string getSelectedAuton() {
-  return currentlySelected;
+  previewLock.take(TIMEOUT_MAX);
+  std::string ret = currentlySelected;
+  previewLock.give();
+  return ret;
 }
 std::vector<std::string> autonNames;
 std::vector<std::pair<lv_obj_t*, lv_obj_t*>> selectors;
@@ -157,7 +226,10 @@ void addAuton(std::string byName) {
         for(auto &pair: selectors) {
           if(pair.first == obj) {
             lv_btn_set_state(pair.first, LV_BTN_STATE_TGL_REL);
+            //The UI executor notices the change, and plans the preview there.
+            previewLock.take(TIMEOUT_MAX);
             currentlySelected = autonNames[j];
+            previewLock.give();
           } else {
             lv_btn_set_state(pair.first, LV_BTN_STATE_REL);
           }
@@ -245,6 +317,231 @@ void autoSelector() {
   lv_btn_set_state(selectors[0].first, LV_BTN_STATE_TGL_REL);
 }
 
+//---------------------------------------
+//  Auton Path Preview
+//---------------------------------------
+//An auton's planned path in pixels on the debug field, indexed by side (red, blue).
+struct PathPreview {
+  std::vector<lv_point_t> path[2];
+  //Where each motion that moves the base ends.
+  std::vector<lv_point_t> stops[2];
+};
+//Previews by auton name. Guarded by previewLock, as are previewAutons & previewChanged.
+std::map<std::string, PathPreview> previewCache;
+//Copy of getState()["autons"] as of the last save, which previews are planned from.
+json previewAutons;
+bool previewChanged = true;
+//What's drawn, copied out of the cache so it can change underneath.
+std::vector<lv_point_t> shownPath;
+std::vector<lv_obj_t*> shownStops;
+std::string shownName;
+bool shownBlue = false;
+
+//Plans an auton into the preview cache. Only the UI executor plans, from a
+//copy of the auton, so planning never reads the state while catOS edits it.
+void cachePreview(const std::string& name) {
+  previewLock.take(TIMEOUT_MAX);
+  auto found = previewAutons.find(name);
+  const bool exists = found != previewAutons.end();
+  const json auton = exists ? *found : json();
+  previewLock.give();
+  PathPreview preview;
+  if(exists) {
+    for(int blue = 0; blue < 2; blue++) {
+      auto plan = planAuton(auton, blue);
+      for(size_t i = 0; i < plan.size(); i++) {
+        lv_point_t pixel = {(lv_coord_t)(plan[i].x * 180 / 144), (lv_coord_t)(180 - plan[i].y * 180 / 144)};
+        preview.path[blue].push_back(pixel);
+        if(i + 1 == plan.size() || plan[i + 1].motion != plan[i].motion) {
+          preview.stops[blue].push_back(pixel);
+        }
+      }
+    }
+  }
+  previewLock.take(TIMEOUT_MAX);
+  previewCache[name] = std::move(preview);
+  previewChanged = true;
+  previewLock.give();
+}
+
+//Drops every preview when the state is saved, keeping a copy of the autons
+//to replan from. Runs on the save writer, with the copy it just wrote.
+void invalidatePreviews(const json& state) {
+  auto found = state.find("autons");
+  json autons = found != state.end() ? *found : json::object();
+  previewLock.take(TIMEOUT_MAX);
+  previewAutons = std::move(autons);
+  previewCache.clear();
+  previewChanged = true;
+  previewLock.give();
+}
+
+//Plans the selected auton if it isn't cached, and draws its path on the
+//debug field if it changed.
+void updatePreview() {
+  const bool blue = getBlue();
+  previewLock.take(TIMEOUT_MAX);
+  const std::string selected = currentlySelected;
+  const bool cached = previewCache.count(selected);
+  previewLock.give();
+  if(!cached) cachePreview(selected);
+  previewLock.take(TIMEOUT_MAX);
+  if(!previewChanged && shownName == selected && shownBlue == blue) {
+    previewLock.give();
+    return;
+  }
+  previewChanged = false;
+  shownName = selected;
+  shownBlue = blue;
+  std::vector<lv_point_t> stops;
+  auto found = previewCache.find(shownName);
+  if(found != previewCache.end()) {
+    shownPath = found->second.path[blue];
+    stops = found->second.stops[blue];
+  } else {
+    shownPath.clear();
+  }
+  previewLock.give();
+  lv_line_set_points(previewLine, shownPath.data(), shownPath.size());
+  for(auto *stop: shownStops) lv_obj_del(stop);
+  shownStops.clear();
+  static lv_style_t stopStyle;
+  lv_style_copy(&stopStyle, &lv_style_plain);
+  stopStyle.body.main_color = LV_COLOR_HEX(0xFFFF00);
+  stopStyle.body.grad_color = LV_COLOR_HEX(0xFFFF00);
+  for(auto &pixel: stops) {
+    lv_obj_t* stop = lv_obj_create(debugField, NULL);
+    lv_obj_set_style(stop, &stopStyle);
+    lv_obj_set_size(stop, 6, 6);
+    lv_obj_set_pos(stop, pixel.x - 3, pixel.y - 3);
+    lv_obj_set_click(stop, false);
+    shownStops.push_back(stop);
+  }
+}
+
+//---------------------------------------
+//  Strip Charts
+//---------------------------------------
+//Whether the strip charts cover the screen. Set by catOS, applied by the UI executor.
+std::atomic_bool stripChartsShown{false};
+//Set by catOS to clear the charts. Cleared by the UI executor once it has.
+std::atomic_bool stripChartsReset{false};
+//Points across each chart. At the control loops' 10 ms, a second of history.
+const uint16_t stripChartPoints = 100;
+
+//One strip chart of up to two signals, whose range grows to fit them.
+struct StripChart {
+  const char* name;
+  lv_obj_t* chart;
+  lv_obj_t* label;
+  lv_chart_series_t* series[2];
+  //Magnitude at the top & bottom of the chart.
+  float scale;
+};
+//Error, velocity & current charts of the base, then of the angler.
+StripChart stripCharts[2][3] = {
+  {{"Base err"}, {"Base vel"}, {"Base mA"}},
+  {{"Angler err"}, {"Angler vel"}, {"Angler mA"}},
+};
+lv_obj_t* stripChartPage;
+
+//Sets a chart's range to +-scale, and labels it so.
+void setStripChartScale(StripChart& strip, float scale) {
+  strip.scale = scale;
+  lv_chart_set_range(strip.chart, -scale, scale);
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%s +-%.0f", strip.name, scale);
+  lv_label_set_text(strip.label, buf);
+}
+
+//Adds a point to each of a chart's series, doubling its range until they fit.
+//Second is ignored if the chart has one series.
+void plotStripChart(StripChart& strip, float first, float second) {
+  float biggest = std::max(std::abs(first), strip.series[1] ? std::abs(second) : 0.0f);
+  if(biggest > strip.scale) {
+    float scale = strip.scale;
+    //lv_coord_t can't hold much more.
+    while(scale < biggest && scale < 16384) scale *= 2;
+    setStripChartScale(strip, scale);
+  }
+  auto clampCoord = [&](float value) { return (lv_coord_t)std::clamp(value, -strip.scale, strip.scale); };
+  lv_chart_set_next(strip.chart, strip.series[0], clampCoord(first));
+  if(strip.series[1]) lv_chart_set_next(strip.chart, strip.series[1], clampCoord(second));
+}
+
+//Flattens every chart to 0, and shrinks them back to their smallest range.
+void resetStripCharts() {
+  for(auto &column: stripCharts) {
+    for(auto &strip: column) {
+      for(auto *series: strip.series) {
+        if(series) lv_chart_init_points(strip.chart, series, 0);
+      }
+      setStripChartScale(strip, 10);
+    }
+  }
+}
+
+//Creates the chart page, hidden, over the rest of the screen.
+void createStripCharts() {
+  stripChartPage = lv_obj_create(lv_scr_act(), NULL);
+  lv_obj_set_size(stripChartPage, LV_HOR_RES, LV_VER_RES);
+  lv_obj_set_style(stripChartPage, &lv_style_plain);
+  static lv_style_t chartStyle;
+  lv_style_copy(&chartStyle, &lv_style_pretty);
+  chartStyle.body.radius = 0;
+  chartStyle.line.color = LV_COLOR_HEX(0x606060);
+  for(int column = 0; column < 2; column++) {
+    for(int row = 0; row < 3; row++) {
+      auto &strip = stripCharts[column][row];
+      strip.chart = lv_chart_create(stripChartPage, NULL);
+      lv_chart_set_style(strip.chart, &chartStyle);
+      lv_obj_set_size(strip.chart, 236, 76);
+      lv_obj_set_pos(strip.chart, column * 240 + 2, row * 80 + 2);
+      lv_chart_set_type(strip.chart, LV_CHART_TYPE_LINE);
+      lv_chart_set_point_count(strip.chart, stripChartPoints);
+      //One division, at 0.
+      lv_chart_set_div_line_count(strip.chart, 1, 0);
+      lv_chart_set_series_width(strip.chart, 1);
+      //Velocity charts show the commanded velocity in yellow, under the measured.
+      strip.series[0] = lv_chart_add_series(strip.chart, row == 1 ? LV_COLOR_HEX(0xFFFF00) : LV_COLOR_HEX(0x0000FF));
+      strip.series[1] = row == 1 ? lv_chart_add_series(strip.chart, LV_COLOR_HEX(0x0000FF)) : nullptr;
+      strip.label = lv_label_create(strip.chart, NULL);
+      lv_obj_set_pos(strip.label, 4, 2);
+    }
+  }
+  resetStripCharts();
+  lv_obj_set_hidden(stripChartPage, true);
+}
+
+//Plots every sample waiting in a trace. Drained even while hidden, so the
+//charts pick up from now when shown, and the trace never fills up.
+void drainTrace(TraceRing& trace, StripChart (&charts)[3], bool shown) {
+  TraceSample sample;
+  while(trace.pop(sample)) {
+    if(!shown) continue;
+    plotStripChart(charts[0], sample.error, 0);
+    plotStripChart(charts[1], sample.commanded, sample.actual);
+    plotStripChart(charts[2], sample.current, 0);
+  }
+}
+
+//Shows or hides the charts as catOS asks, and plots the latest samples.
+void updateStripCharts() {
+  static bool lastShown = false;
+  const bool shown = stripChartsShown.load();
+  if(shown != lastShown) {
+    lastShown = shown;
+    lv_obj_set_hidden(stripChartPage, !shown);
+  }
+  if(stripChartsReset.load()) {
+    resetStripCharts();
+    stripChartsReset.store(false);
+  }
+  auto &bot = getRobot();
+  drainTrace(bot.baseSettings.getTrace(), stripCharts[0], shown);
+  drainTrace(bot.puncher.getTrace(), stripCharts[1], shown);
+}
+
 //-------------------------------------
 //  UI Executor
 //-------------------------------------
@@ -257,9 +554,16 @@ void uiExecutor(void*) {
   putImage();
   autoSelector();
   oyes();
+  createStripCharts();
+  //Takes the first copy of the autons to plan previews from.
+  invalidatePreviews(getState());
+  onStateSaved(invalidatePreviews);
   while(true) {
     pros::c::task_delay_until(&startTime, 50);
     updateRobot();
+    updatePreview();
+    updateStripCharts();
+    updateAutonEditor();
     int currentStatus = pros::competition::get_status();
     int curMenuEnter = menuWasEntered;
     if(currentStatus != lastCompStatus || curMenuEnter != lastMenuWasEntered) {
@@ -302,13 +606,13 @@ void uiExecutor(void*) {
  * Monitors an Elliot2CCPID as it uses its PID loop.
  */
 void pidMonitor(okapi::Elliot2CCPID& cc) {
-  auto &ctrl = getRobot().controller;
+  auto &ctrl = menuInput();
   auto beginTime = pros::millis();
   line_set(0, "PID NOT SETTLED");
   line_set(1, "B TO DISMISS");
   line_set(2, "");
   while(!cc.isSettled()) {
-    if(ctrl.get_digital_new_press(DIGITAL_B)) {
+    if(ctrl.newPress(DIGITAL_B)) {
       cc.stop();
       return;
     }
@@ -316,12 +620,13 @@ void pidMonitor(okapi::Elliot2CCPID& cc) {
   }
   auto settleTime = pros::millis() - beginTime;
   auto finalError = cc.getError();
-  auto finalVelocity = (std::abs(getRobot().left.getActualVelocity()) + std::abs(getRobot().right.getActualVelocity())) / 2.0;
+  auto &monitor = getRobot().driveMonitor;
+  auto finalVelocity = (std::abs(monitor.getVelocity(DriveMonitor::LEFT)) + std::abs(monitor.getVelocity(DriveMonitor::RIGHT))) / 2.0;
   line_set(0, "sT: " + std::to_string(settleTime) + "ms");
   line_set(1, "fE: " + std::to_string(finalError));
   line_set(2, "fV: " + std::to_string(finalVelocity));
-  while(!ctrl.get_digital_new_press(DIGITAL_B)) {
-    pros::delay(5);
+  while(!ctrl.newPress(DIGITAL_B)) {
+    ctrl.wait(menuWaitTimeout);
   }
   cc.stop();
 }
@@ -340,6 +645,17 @@ class PIDTestingMenu: public ControllerMenu {
         auto &base = *getRobot().base;
         base.moveDistanceAsync(editNumber(90, 1) * okapi::inch);
         pidMonitor(base);
+      }},
+      {"Arc", [&]() {
+        auto &base = *getRobot().base;
+        double radius = editNumber(24, 1);
+        base.arcAsync(radius * okapi::inch, editNumber(90, 1) * okapi::degree);
+        pidMonitor(base);
+      }},
+      {"Swing", [&]() {
+        auto &base = *getRobot().base;
+        base.swingAsync(editNumber(90, 1) * okapi::degree, false);
+        pidMonitor(base);
       }}
     });
   }
@@ -349,18 +665,18 @@ class PIDTestingMenu: public ControllerMenu {
 bool criticalBattIgnored = false;
 
 //Stalls the menu system if the battery is low.
-ControllerTask::CheckResult checkBattery(pros::Controller& ctrl) {
+ControllerTask::CheckResult checkBattery(InputQueue& ctrl) {
   if(!criticalBattIgnored && pros::battery::get_capacity() < 15) {
     line_set(0, "Battery is");
     line_set(1, "< 15. Please");
     line_set(2, "B to dismiss");
     int iter = 0;
-    while(!(criticalBattIgnored = ctrl.get_digital(DIGITAL_B))) {
+    while(!(criticalBattIgnored = ctrl.held(DIGITAL_B))) {
       pros::delay(20);
       iter++;
       if(iter == 100) {
         iter = 0;
-        ctrl.rumble(".");
+        getRobot().controller.rumble(".");
       }
     }
     return ControllerTask::CheckResult::RERENDER;
@@ -368,11 +684,212 @@ ControllerTask::CheckResult checkBattery(pros::Controller& ctrl) {
   return ControllerTask::CheckResult::NO_CHANGE;
 }
 
+//A value the dashboard can show on one controller line.
+struct DashboardChannel {
+  const char *name;
+  ///Writes the value into buf, in at most lineWidth characters.
+  void (*format)(const TelemetrySnapshot& snapshot, char *buf, size_t size);
+};
+
+//Hottest of a list of motors, or 0 if none answered.
+static double hottest(const TelemetrySnapshot& snapshot, std::initializer_list<int> ports) {
+  double hottest = 0;
+  for(int port: ports) {
+    auto &motor = snapshot.motor(port);
+    if(motor.valid) hottest = std::max(hottest, motor.temperature);
+  }
+  return hottest;
+}
+
+//Everything the dashboard can show, all from one telemetry snapshot, so nothing here locks
+//or reaches into a base that may be rebuilt.
+static const DashboardChannel dashboardChannels[] = {
+  {"Pose", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    auto &gps = getRobot().gps;
+    snprintf(buf, size, "%.1f %.1f %.0f", gps.countsToInch(snapshot.x), gps.countsToInch(snapshot.y), snapshot.o * 180 / PI);
+  }},
+  {"PID Error", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    snprintf(buf, size, "E%.1f %s", snapshot.base.error, snapshot.base.settled ? "done" : "busy");
+  }},
+  {"Velocity", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    snprintf(buf, size, "V L%.0f R%.0f", snapshot.leftVelocity, snapshot.rightVelocity);
+  }},
+  {"Drive Temps", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    snprintf(buf, size, "T L%.0f R%.0f", hottest(snapshot, {motorPorts::left1, motorPorts::left2}),
+      hottest(snapshot, {motorPorts::right1, motorPorts::right2}));
+  }},
+  {"Mech Temps", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    snprintf(buf, size, "P%.0f A%.0f I%.0f S%.0f", hottest(snapshot, {motorPorts::puncher}), hottest(snapshot, {motorPorts::angler}),
+      hottest(snapshot, {motorPorts::intake}), hottest(snapshot, {motorPorts::scorer}));
+  }},
+  {"Battery", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    snprintf(buf, size, "B %.2fV %.0f%%", snapshot.batteryVoltage / 1000, snapshot.batteryCapacity);
+  }},
+  {"Loop Jitter", [](const TelemetrySnapshot& snapshot, char *buf, size_t size) {
+    snprintf(buf, size, "J%u/%u ovr%u", (unsigned)snapshot.base.jitter, (unsigned)snapshot.base.maxJitter, (unsigned)snapshot.base.overruns);
+  }}
+};
+const int dashboardChannelCount = sizeof(dashboardChannels) / sizeof(dashboardChannels[0]);
+//Which channels the dashboard shows, in order. Kept between visits.
+static bool dashboardShown[dashboardChannelCount] = {true, true, true};
+
+/**
+ * Streams the selected channels to the controller. Only one line changes per
+ * controller slot, taking turns, and a line whose text hasn't changed gives
+ * its turn to the next, so every line stays as fresh as the slots allow.
+ * It never takes the robot, so it can run from the catOS home screen while
+ * driving: there, Up+Down exits, as B belongs to opcontrol.
+ */
+class Dashboard: public ControllerTask {
+  std::vector<int> channels;
+  //Index in channels of the top line.
+  int first = 0;
+  //Line to try updating next.
+  int next = 0;
+  uint32_t lastUpdate = 0;
+  std::string lastText[3];
+  bool fromHome;
+  //Text for a line, right now.
+  std::string lineText(int line, const TelemetrySnapshot& snapshot) {
+    if(first + line >= (int)channels.size()) return "";
+    char buf[32];
+    dashboardChannels[channels[first + line]].format(snapshot, buf, sizeof(buf));
+    return buf;
+  }
+  public:
+  Dashboard(bool ifromHome = false): fromHome(ifromHome) {
+    for(int i = 0; i < dashboardChannelCount; i++) {
+      if(dashboardShown[i]) channels.push_back(i);
+    }
+  }
+  void render() override {
+    TelemetrySnapshot snapshot;
+    getTelemetry(snapshot);
+    for(int i = 0; i < 3; i++) {
+      lastText[i] = lineText(i, snapshot);
+      line_set(i, lastText[i]);
+    }
+    if(channels.empty()) line_set(0, "No channels");
+    lastUpdate = pros::millis();
+  }
+  int checkController() override {
+    auto &ctrl = menuInput();
+    if(fromHome ? ctrl.held(DIGITAL_UP) && ctrl.held(DIGITAL_DOWN) : ctrl.newPress(DIGITAL_B)) {
+      while(ctrl.held(DIGITAL_UP) || ctrl.held(DIGITAL_DOWN)) pros::delay(25);
+      ctrl.clear();
+      return GO_UP;
+    }
+    //From home the left joystick is driving, so only the buttons scroll.
+    int dir = fromHome ? !!ctrl.newPressOrRepeat(DIGITAL_DOWN) - !!ctrl.newPressOrRepeat(DIGITAL_UP) : getVerticalDirection(-1);
+    if(dir && channels.size() > 3) {
+      first = std::clamp(first + dir, 0, (int)channels.size() - 3);
+      return RERENDER;
+    }
+    //Same pace as the screen's flush task, so each update goes out before the next.
+    if(pros::millis() - lastUpdate < controllerSlot + 2) return NO_CHANGE;
+    lastUpdate = pros::millis();
+    TelemetrySnapshot snapshot;
+    getTelemetry(snapshot);
+    for(int tries = 0; tries < 3; tries++) {
+      const int line = next;
+      next = (next + 1) % 3;
+      auto text = lineText(line, snapshot);
+      if(text != lastText[line]) {
+        lastText[line] = text;
+        line_set(line, text);
+        break;
+      }
+    }
+    return NO_CHANGE;
+  }
+  //Runs without checkTemporaryExit(), which would hand over a robot this never took.
+  void runFromHome() {
+    render();
+    while(checkController() != GO_UP) {
+      if(checkBattery(menuInput())) render();
+      menuInput().wait(menuWaitTimeout);
+    }
+  }
+};
+
+//Picks the dashboard's channels, and shows it.
+class DashboardMenu: public ControllerMenu {
+  void refresh() {
+    for(int i = 0; i < dashboardChannelCount; i++) {
+      list[i + 1].first = std::string(dashboardShown[i] ? "[x] " : "[ ] ") + dashboardChannels[i].name;
+    }
+  }
+  public:
+  DashboardMenu() {
+    list.push_back({"Show", taskOption<Dashboard>});
+    for(int i = 0; i < dashboardChannelCount; i++) {
+      list.push_back({"", [i, this]() {
+        dashboardShown[i] = !dashboardShown[i];
+        refresh();
+      }});
+    }
+    refresh();
+  }
+};
+
+//Shows the base & angler strip charts on the brain, which stay up while
+//other menus run moves.
+class StripChartMenu: public ControllerMenu {
+  void refresh() {
+    list[0].first = stripChartsShown.load() ? "[x] On brain" : "[ ] On brain";
+  }
+  public:
+  StripChartMenu() {
+    list.push_back({"", [this]() {
+      stripChartsShown.store(!stripChartsShown.load());
+      refresh();
+    }});
+    list.push_back({"Clear", []() {
+      stripChartsReset.store(true);
+    }});
+    refresh();
+  }
+};
+
+//Shows how many saves were coalesced, and how long their SD card writes took:
+//J lines are journal appends, S lines snapshot rewrites.
+class SaveStatsMenu: public ControllerMenu {
+  void refresh() {
+    auto &stats = getSaveStats();
+    char buf[32];
+    snprintf(buf, sizeof(buf), "Saves %u/%u", (unsigned)stats.written.load(), (unsigned)stats.requested.load());
+    list[2].first = buf;
+    snprintf(buf, sizeof(buf), "Max %ums", (unsigned)stats.maxLatency.load());
+    list[3].first = buf;
+    for(int i = 0; i < saveLatencyBuckets; i++) {
+      char bound[8];
+      if(i < saveLatencyBuckets - 1) snprintf(bound, sizeof(bound), "<%u", (unsigned)saveLatencyBounds[i]);
+      else snprintf(bound, sizeof(bound), "%u+", (unsigned)saveLatencyBounds[i - 1]);
+      snprintf(buf, sizeof(buf), "J %sms %u", bound, (unsigned)stats.journalWrites[i].load());
+      list[4 + i].first = buf;
+      snprintf(buf, sizeof(buf), "S %sms %u", bound, (unsigned)stats.snapshotWrites[i].load());
+      list[4 + saveLatencyBuckets + i].first = buf;
+    }
+  }
+  public:
+  SaveStatsMenu() {
+    list.push_back({"Refresh", [this]() { refresh(); }});
+    list.push_back({"Reset", [this]() {
+      resetSaveStats();
+      refresh();
+    }});
+    for(int i = 0; i < 2 + 2 * saveLatencyBuckets; i++) {
+      list.push_back({"", []() {}});
+    }
+    refresh();
+  }
+};
+
 //Allows you to drive before selecting a menu option.
 ControllerTask::CheckResult checkTemporaryExit() {
-  auto &ctrl = getRobot().controller;
-  if(ctrl.get_digital_new_press(DIGITAL_Y)) {
-    if(!ctrl.get_digital(DIGITAL_RIGHT)) {
+  auto &ctrl = menuInput();
+  if(ctrl.newPress(DIGITAL_Y)) {
+    if(!ctrl.held(DIGITAL_RIGHT)) {
       line_set(0, "Now driving,");
       line_set(1, "Press Y");
       line_set(2, "to exit.");
@@ -381,13 +898,15 @@ ControllerTask::CheckResult checkTemporaryExit() {
       bot.driveStyle = UNGATO_DRIVING;
       Elliot::give();
       while(true) {
-        if(ctrl.get_digital(DIGITAL_Y)) {
-          while(ctrl.get_digital(DIGITAL_Y)) pros::delay(25);
+        if(ctrl.newPress(DIGITAL_Y)) {
+          while(ctrl.held(DIGITAL_Y)) pros::delay(25);
           bot.driveStyle = DADDY_DRIVING;
           Elliot::takeStopped();
+          //Presses made while driving were meant for opcontrol.
+          ctrl.clear();
           break;
         }
-        pros::delay(5);
+        ctrl.wait(menuWaitTimeout);
       }
     } else {
       PIDTestingMenu()();
@@ -434,51 +953,28 @@ class MotionEditor: public ControllerMenu {
     list.insert(list.end(), conveniences);
     list.insert(list.end(), {
       {"Run this", [&auton, idx, &object]() {
-        auto &bot = getRobot();
-        auto old = bot.left.getBrakeMode();
-        //Track with current offset
-        auto tracking = offsetFor(auton, idx);
-        runMotion(object, tracking, getBlue());
-        bot.base->stop();
+        runJob("Running motion", [&auton, idx, &object]() {
+          //Track with current offset
+          auto tracking = offsetFor(auton, idx);
+          runMotion(object, tracking, getBlue());
+        });
       }},
       {"Run to here", [&auton, idx, this]() {
-        //Okay to use a lambda, as long as it isn't destructed in the task's lifetime.
-        std::function<void(void)> lamb = [&auton, idx]() {
-          runAuton(auton.begin(), auton.begin() + idx + 1, getBlue());
-        };
-        //Start task
-        pros::Task autonRunner{[](void* param) {
-          (*(std::function<void(void)>*)param)();
-        }, (void*)&lamb};
-        //Display stoppable message
-        line_set(0, "Running auton,");
-        line_set(1, "Press B");
-        line_set(2, "to stop.");
         //Measure starting time
         long autonStartTime = pros::millis();
-        //Take care of task
-        bool wasStopped = false;
-        auto &ctrl = getRobot().controller;
-        while(autonRunner.get_state() != pros::E_TASK_STATE_DELETED) {
-          if(ctrl.get_digital_new_press(DIGITAL_B)) {
-            wasStopped = true;
-            autonRunner.remove();
-            break;
-          }
-          pros::delay(5);
-        }
-        getRobot().scorer.moveVelocity(0);
+        bool finished = runJob("Running auton", [&auton, idx]() {
+          runAuton(auton.begin(), auton.begin() + idx + 1, getBlue());
+        });
         //Measure finish time
         long finishedIn = pros::millis() - autonStartTime;
-        //Stop robot
-        getRobot().stop();
         //Display finish time
-        line_set(0, wasStopped ? "Interrupted at" : "Auton done in");
+        line_set(0, finished ? "Auton done in" : "Interrupted at");
         line_set(1, std::to_string(finishedIn) + "ms.");
         line_set(2, "A to dismiss");
         //Wait for A to be pressed again
-        while(!ctrl.get_digital_new_press(DIGITAL_A)) pros::delay(5);
-        //Task is gone. Render, and close the scope.
+        auto &ctrl = menuInput();
+        while(!ctrl.newPress(DIGITAL_A)) ctrl.wait(menuWaitTimeout);
+        //Job is done. Render, and close the scope.
         render();
       }}
     });
@@ -488,12 +984,7 @@ class MotionEditor: public ControllerMenu {
 //Can edit an autonomous, given its motion list.
 class MotionList: public CRUDMenu {
   json &motionData;
-  void jsonInserter(const std::string& name, json defaultValue = {}, std::string type = "") {
-    if(type == "") {
-      type = name;
-      std::transform(type.begin(), type.end(), type.begin(), ::tolower);
-    }
-    defaultValue["type"] = type;
+  void jsonInserter(const std::string& name, json defaultValue) {
     addInserter(name, [this, defaultValue](int index) -> std::string {
       motionData.insert(motionData.begin() + index, defaultValue);
       return nameFor(motionData[index]);
@@ -501,27 +992,9 @@ class MotionList: public CRUDMenu {
   }
   public:
   MotionList(std::string autonName): CRUDMenu(), motionData(getState()["autons"][autonName]) {
-    //Add inserters here
-    auto &bot = getRobot();
-    jsonInserter("SLine"   , { {"d", 0.0}, {"t", 0.2}, {"v", 1.0} });
-    jsonInserter("Position", { {"x", 0.0}, {"y", 0.0}, {"t", 0.2}, {"rT", 0.2}, {"v", 1.0}, {"r", false} });
-    jsonInserter("Rotation", { {"o", 0.0}, {"t", 0.2}, {"v", 1.0} }, "rotateTo");
-    jsonInserter("Direct"  , { {"l", 1.0}, {"r", 1.0}, {"t", 1.0} });
-    jsonInserter("Low"     , { {"t", 0.0} });
-    jsonInserter("High"    , { {"t", 0.0} });
-    jsonInserter("Punch"   , { {"t", 0.0} });
-    jsonInserter("Autoshoot");
-    jsonInserter("Intake"  , { {"v", 1.0}, {"t", 0.2} });
-    jsonInserter("Scorer"  , { {"p", 10 }, {"v", 1.0}, {"t", 0.6} });
-    jsonInserter("Delta"   , { {"x", 0.0}, {"y", 0.0}, {"o", 0.0} });
-    jsonInserter("Delay"   , { {"t", 0} });
-    jsonInserter("Hold");
-    jsonInserter("Coast");
-    jsonInserter("Short");
-    jsonInserter("Origin", {
-      {"name", "ORIGIN"},
-      {"x", 0.0}, {"y", 0.0}, {"o", 0.0}
-    });
+    for(auto &motion: motionTemplates()) {
+      jsonInserter(motion.name, motion.motion);
+    }
     //Add existing items
     for(auto &motion: motionData) {
       addItem(nameFor(motion));
@@ -552,22 +1025,25 @@ class MotionList: public CRUDMenu {
       }, {
         {"Move Here", [&motionSelected](){
           json copy = motionSelected;
-          double x = copy["x"].get<double>();
-          if(getBlue()) {
-            x = 144 - x;
-          }
-          moveToSetpoint({
-            getRobot().gps.inchToCounts(x),
-            getRobot().gps.inchToCounts(copy["y"].get<double>()),
-            0
-          }, 1.0, false, 1000);
-          RoboPosition tracking;
-          runMotion({
-            {"type", "rotateTo"},
-            {"o", copy["o"].get<double>()},
-            {"v", 1.0},
-            {"t", 2.0}
-          }, tracking, getBlue());
+          runJob("Moving to origin", [&copy]() {
+            double x = copy["x"].get<double>();
+            if(getBlue()) {
+              x = 144 - x;
+            }
+            moveToSetpoint({
+              getRobot().gps.inchToCounts(x),
+              getRobot().gps.inchToCounts(copy["y"].get<double>()),
+              0
+            }, 1.0, false, 1000);
+            if(jobCancelled()) return;
+            RoboPosition tracking;
+            runMotion({
+              {"type", "rotateTo"},
+              {"o", copy["o"].get<double>()},
+              {"v", 1.0},
+              {"t", 2.0}
+            }, tracking, getBlue());
+          });
         }},
         //Shows up as "*Set Orientatio" due to character limit
         {"Set Orientation", [&motionSelected]() {
@@ -669,6 +1145,23 @@ class MotionList: public CRUDMenu {
         {"v", 2, "Set velocity"},
         {"t", 3, "Set timing"}
       })();
+    } else if(type == "arc") {
+      MotionEditor(motionData, idx, {
+        {"r", 2, "Set radius"},
+        {"a", 2, "Set angle"},
+        {"v", 2, "Set velocity"},
+        {"t", 3, "Set timing"}
+      })();
+    } else if(type == "swing") {
+      MotionEditor(motionData, idx, {
+        {"a", 2, "Set angle"},
+        {"v", 2, "Set velocity"},
+        {"t", 3, "Set timing"}
+      }, {
+        {"Set Pivot", [&motionSelected]() {
+          motionSelected["l"] = !!selectOption({"Right", "Left"}, motionSelected["l"].get<bool>() ? 1 : 0);
+        }}
+      })();
     } else if(type == "low" || type == "high" || type == "punch") {
       MotionEditor(motionData, idx, {
         {"t", 3, "Set timing"}
@@ -715,6 +1208,10 @@ class AutonList: public CRUDMenu {
       addAuton("unnamed");
       return "unnamed";
     });
+    addConvenience("edit on brain", [](int idx, std::string name) {
+      editAutonOnBrain(name);
+      saveState();
+    });
     //Add existing items
     for(auto &[k, v]: autonData.items()) {
       addItem(k);
@@ -779,15 +1276,15 @@ class MotorTest: public ControllerTask {
     line_set(2, "Or use left joy");
   }
   int checkController() override {
-    auto &ctrl = getRobot().controller;
-    if(ctrl.get_digital(DIGITAL_LEFT)) {
+    auto &ctrl = menuInput();
+    if(ctrl.held(DIGITAL_LEFT)) {
       m.move_velocity(-200);
-    } else if(ctrl.get_digital(DIGITAL_RIGHT)) {
+    } else if(ctrl.held(DIGITAL_RIGHT)) {
       m.move_velocity(200);
     } else {
-      m.move_velocity(ctrl.get_analog(ANALOG_LEFT_Y) * 200 / 127.0);
+      m.move_velocity(ctrl.analog(ANALOG_LEFT_Y) * 200 / 127.0);
     }
-    if(ctrl.get_digital(DIGITAL_B)) {
+    if(ctrl.held(DIGITAL_B)) {
       return GO_UP;
     } else {
       return NO_CHANGE;
@@ -840,8 +1337,8 @@ class GPSCalibrator: public ControllerTask {
   }
 
   int checkController() override {
-    auto &ctrl = getRobot().controller;
-    if(ctrl.get_digital_new_press(DIGITAL_A)) {
+    auto &ctrl = menuInput();
+    if(ctrl.newPress(DIGITAL_A)) {
       if(state == 0) {
         double lastAvg = (initial_left + initial_right) / 2;
         double curAvg = (robot.left .getPosition() + robot.right.getPosition()) / 2;
@@ -864,19 +1361,19 @@ class GPSCalibrator: public ControllerTask {
       }
     }
     if(state == 0) {
-      double y = (!!ctrl.get_digital(DIGITAL_RIGHT) - !!ctrl.get_digital(DIGITAL_LEFT));
-      if(!y) y = ctrl.get_analog(ANALOG_LEFT_Y) / 127.0;
+      double y = (!!ctrl.held(DIGITAL_RIGHT) - !!ctrl.held(DIGITAL_LEFT));
+      if(!y) y = ctrl.analog(ANALOG_LEFT_Y) / 127.0;
       y = y * y * y;
       robot. left.moveVelocity(y * (int)robot. left.getGearing());
       robot.right.moveVelocity(y * (int)robot.right.getGearing());
     } else if(state == 2) {
-      double x = (!!ctrl.get_digital(DIGITAL_RIGHT) - !!ctrl.get_digital(DIGITAL_LEFT));
-      if(!x) x = ctrl.get_analog(ANALOG_LEFT_X) / 127.0;
+      double x = (!!ctrl.held(DIGITAL_RIGHT) - !!ctrl.held(DIGITAL_LEFT));
+      if(!x) x = ctrl.analog(ANALOG_LEFT_X) / 127.0;
       x = x * x * x;
       robot. left.moveVelocity( x * (int)robot. left.getGearing());
       robot.right.moveVelocity(-x * (int)robot.right.getGearing());
     }
-    if(ctrl.get_digital_new_press(DIGITAL_B)) {
+    if(ctrl.newPress(DIGITAL_B)) {
       return GO_UP;
     } else {
       return NO_CHANGE;
@@ -884,6 +1381,28 @@ class GPSCalibrator: public ControllerTask {
   }
 };
 
+//Shows the health of every base motor, as seen by the DriveMonitor.
+class DriveHealthList: public ControllerMenu {
+  //Updates the names of the motor entries, which come first in the list.
+  void refresh() {
+    int i = 0;
+    for(auto &status: getRobot().driveMonitor.getStatus()) {
+      list[i++].first = std::string(status.side == DriveMonitor::LEFT ? "L" : "R") +
+        std::to_string(std::abs(status.port)) + " " + faultName(status.fault);
+    }
+  }
+  public:
+  DriveHealthList() {
+    auto &monitor = getRobot().driveMonitor;
+    list.resize(monitor.getStatus().size(), {"", [](){}});
+    list.push_back({"Clear Faults", [&monitor, this]() {
+      monitor.clearFaults();
+      refresh();
+    }});
+    refresh();
+  }
+};
+
 //Edits the GPS position.
 class GPSPositionList: public ControllerMenu {
   public:
@@ -928,6 +1447,152 @@ class PIDGainsList: public ControllerMenu {
   }
 };
 
+//Edits feedforward constants & profile limits.
+class FeedforwardList: public ControllerMenu {
+  public:
+  FeedforwardList(Feedforward& ff) {
+    list.insert(list.end(), {
+      {"Set kS", [&]() {
+        ff.kS = editNumber(ff.kS, 1);
+      }},
+      {"Set kV", [&]() {
+        ff.kV = editNumber(ff.kV, 4);
+      }},
+      {"Set kA", [&]() {
+        ff.kA = editNumber(ff.kA, 4);
+      }},
+      {"Max Velocity", [&]() {
+        ff.maxVelocity = editNumber(ff.maxVelocity, 0);
+      }},
+      {"Max Accel", [&]() {
+        ff.maxAcceleration = editNumber(ff.maxAcceleration, 0);
+      }}
+    });
+  }
+};
+
+//Edits a PID's derivative filter & integral options.
+class PIDOptionsList: public ControllerMenu {
+  public:
+  PIDOptionsList(PIDOptions& opts) {
+    list.insert(list.end(), {
+      {"D Filter", [&]() {
+        opts.filter = (DerivativeFilter)selectOption(derivativeFilterNames(), (int)opts.filter);
+      }},
+      {"Filter Alpha", [&]() {
+        opts.alpha = editNumber(opts.alpha, 3);
+      }},
+      {"I Limit", [&]() {
+        opts.integralLimit = editNumber(opts.integralLimit, 3);
+      }},
+      {"I Band", [&]() {
+        opts.integralBand = editNumber(opts.integralBand, 1);
+      }},
+      {"I Reset", [&]() {
+        opts.integralReset = selectOption({"Off", "On"}, opts.integralReset ? 1 : 0) == 1;
+      }}
+    });
+  }
+};
+
+//Lists the PIDs whose options can be edited. Saving rebuilds the base's controller.
+class PIDOptionsMenu: public ControllerMenu {
+  public:
+  PIDOptionsMenu() {
+    for(auto &[name, label]: std::initializer_list<std::pair<const char*, const char*>>{
+      {"dist", "Distance Opts"},
+      {"angle", "Angle Opts"},
+      {"turn", "Turn Opts"}
+    }) {
+      list.push_back({label, [name = name]() {
+        auto &set = getRobot().baseSettings;
+        auto opts = set.getPIDOptions(name);
+        PIDOptionsList menu(opts);
+        menu();
+        set.setPIDOptions(name, opts);
+      }});
+    }
+  }
+};
+
+//Edits a gain schedule row's magnitude & gains.
+class ScheduleRowList: public ControllerMenu {
+  public:
+  ScheduleRowList(json& row) {
+    for(auto &[key, fix, option]: std::initializer_list<std::tuple<std::string, int, std::string>>{
+      {"m", 1, "Set magnitude"},
+      {"kP", 12, "Set kP"},
+      {"kI", 8, "Set kI"},
+      {"kD", 12, "Set kD"}
+    }) {
+      list.push_back({option, [&row, key = key, fix = fix]() {
+        row[key] = editNumber(row[key].get<double>(), fix);
+      }});
+    }
+  }
+};
+
+//Can create/remove/edit rows of a gain schedule.
+class ScheduleList: public CRUDMenu {
+  json &rows;
+  std::string unit;
+  public:
+  ScheduleList(const char* name, const std::string& iunit): CRUDMenu(), rows(getRobot().baseSettings.getSchedule(name)), unit(iunit) {
+    addInserter("row", [this, name](int index) -> std::string {
+      auto &set = getRobot().baseSettings;
+      if(rows.size() >= GainSchedule::maxRows) throw "schedule full";
+      auto gains = std::string(name) == "dist" ? set.getDistGains() : std::string(name) == "angle" ? set.getAngleGains() : set.getTurnGains();
+      rows.insert(rows.begin() + index, {{"m", 0.0}, {"kP", gains.kP}, {"kI", gains.kI}, {"kD", gains.kD}});
+      return nameFor(rows[index]);
+    });
+    for(auto &row: rows) {
+      addItem(nameFor(row));
+    }
+  }
+
+  void attemptDelete(int idx, const std::string& oldName) override {
+    rows.erase(rows.begin() + idx);
+  }
+  void attemptMove(int idx, int newIdx, const std::string& oldName) override {
+    std::swap(rows[idx], rows[newIdx]);
+  }
+  std::string attemptDuplicate(int idx, int newIdx, const std::string& oldName) override {
+    if(rows.size() >= GainSchedule::maxRows) throw "schedule full";
+    rows.insert(rows.begin() + newIdx, rows[idx]);
+    return nameFor(rows[newIdx]);
+  }
+
+  void handleSelect(int idx, const std::string& name) override {
+    auto &row = rows[idx];
+    ScheduleRowList menu(row);
+    menu();
+    updateItem(idx, nameFor(row));
+    finalizeData();
+  }
+  void finalizeData() override {
+    saveState();
+    getRobot().baseSettings.retuneSchedules();
+  }
+  private:
+  std::string nameFor(json& row) {
+    char buf[20];
+    snprintf(buf, sizeof(buf), "%.1f%s", row["m"].get<double>(), unit.c_str());
+    return buf;
+  }
+};
+
+//Lists the gain schedules for distance, angle, and turn.
+class ScheduleMenu: public ControllerMenu {
+  public:
+  ScheduleMenu() {
+    list.insert(list.end(), {
+      {"Distance Sched", []() { ScheduleList("dist", "in")(); }},
+      {"Angle Sched", []() { ScheduleList("angle", "in")(); }},
+      {"Turn Sched", []() { ScheduleList("turn", "deg")(); }}
+    });
+  }
+};
+
 //List of gain sets for distance, angle, and turn.
 class GPSGainList: public ControllerMenu {
   public:
@@ -951,158 +1616,125 @@ class GPSGainList: public ControllerMenu {
         PIDGainsList menu(gains);
         menu();
         set.setTurnGains(gains);
+      }},
+      {"Schedules", taskOption<ScheduleMenu>},
+      {"PID Options", taskOption<PIDOptionsMenu>},
+      {"Feedforward", [&]() {
+        auto ff = set.getFeedforward();
+        FeedforwardList menu(ff);
+        menu();
+        set.setFeedforward(ff);
       }}
     });
   }
 };
 
-//OkapiLib issue #317 workaround. Normally, you could directly use a MotorGroup as an output,
-//but due to okapi::MotorGroup::controllerSet not respecting gearsets, you can't.
-class MotorGroupOutput: public ControllerOutput<double> {
-  MotorGroup &group;
-  double scale;
-  public:
-  MotorGroupOutput(MotorGroup& groupRef, double scaler): group(groupRef), scale(scaler) {}
-  void controllerSet(double vel) {
-    group.moveVelocity(vel * (int)group.getGearing() * scale);
-  }
-};
-
-//Can automatically find correct PID values, using okapi::PIDTuner.
-void tuneGains() { 
-  //TODO: Fix the hardcoded ports!
-  MotorGroup entireBase{3, 4, -2, -1};
-  entireBase.setEncoderUnits(AbstractMotor::encoderUnits::degrees);
-  MotorGroup turningBase{3, 4, 2, 1};
-  turningBase.setEncoderUnits(AbstractMotor::encoderUnits::degrees);
-  //Base Settings - controls PID Gains on chassis object
-  auto &settings = getRobot().baseSettings;
-  //Create the tuna for distance
-  auto tuna = PIDTunerFactory::create(entireBase.getEncoder(), std::make_shared<MotorGroupOutput>(entireBase, 0.8),
-    5_s, getRobot().gps.inchToCounts(36),
-    0, 0.0020,
-    0, 0.0025,
-    0, 0.008
-  );
-  //Autotune using the tuna
-  auto tune = tuna.autotune();
-  //Now apply the tuned distance gains to the gps object
-  settings.setDistGains({
-    tune.kP,
-    tune.kI,
-    tune.kD
-  });
-  //Create the tuna for turning
-  auto spintuna = PIDTunerFactory::create(entireBase.getEncoder(), std::make_shared<MotorGroupOutput>(turningBase, 0.8),
-    5_s, getRobot().gps.inchToCounts(36),
-    0, 0.0020,
-    0, 0.0025,
-    0, 0.008
-  );
-  //Autotone spinning
-  auto spintune = spintuna.autotune();
-  //Apply the tuned turn gains to the gps object
-  settings.setAngleGains({
-    spintune.kP,
-    spintune.kI,
-    spintune.kD
-  });
-  settings.setTurnGains(settings.getAngleGains());
-}
-
-//Runs tuneGains() with message on-screen.
+//Relay tests distance & turning, then offers to save gains derived with the selected rule.
 class GainTuner: public ControllerMenu {
   public:
   GainTuner() {}
   void render() override {
-    line_set(0, "Give bot 48in");
-    line_set(1, "space fwd/rev");
+    line_set(0, "Give bot 12in");
+    line_set(1, "space all round");
     line_set(2, "then press A.");
   }
   int checkController() override {
-    auto &ctrl = getRobot().controller;
-    if(ctrl.get_digital_new_press(DIGITAL_B)) return GO_UP;
-    if(ctrl.get_digital_new_press(DIGITAL_A)) {
-      line_set(0, "Now tuning,");
-      line_set(1, "");
-      line_set(2, "Please wait.");
-      tuneGains();
+    auto &ctrl = menuInput();
+    if(ctrl.newPress(DIGITAL_B)) return GO_UP;
+    if(ctrl.newPress(DIGITAL_A)) {
+      RelayResult dist, turn;
+      bool found = false;
+      runJob("Relay testing", [&]() {
+        found = relayTest(RelayAxis::DISTANCE, dist) && (jobDelay(500), relayTest(RelayAxis::TURN, turn));
+      });
+      if(!found) {
+        line_set(0, "No steady");
+        line_set(1, "oscillation.");
+        line_set(2, "");
+        pros::delay(1000);
+        return GO_UP;
+      }
+      auto &set = getRobot().baseSettings;
+      auto rule = set.getTuningRule();
+      auto distGains = gainsFromRule(rule, dist);
+      auto turnGains = gainsFromRule(rule, turn);
+      char buf[3][32];
+      snprintf(buf[0], sizeof(buf[0]), "D Ku%.4f %.2fs", dist.ultimateGain, dist.ultimatePeriod);
+      snprintf(buf[1], sizeof(buf[1]), "T Ku%.4f %.2fs", turn.ultimateGain, turn.ultimatePeriod);
+      snprintf(buf[2], sizeof(buf[2]), "A: save B: drop");
+      for(int i = 0; i < 3; i++) line_set(i, buf[i]);
+      while(true) {
+        if(ctrl.newPress(DIGITAL_B)) break;
+        if(ctrl.newPress(DIGITAL_A)) {
+          set.setDistGains(distGains);
+          set.setTurnGains(turnGains);
+          //Angle correction measures left - right, twice what turning measures.
+          set.setAngleGains({turnGains.kP / 2, turnGains.kI / 2, turnGains.kD / 2, 0});
+          break;
+        }
+        ctrl.wait(menuWaitTimeout);
+      }
       return GO_UP;
     }
     return NO_CHANGE;
   }
 };
 
-TrueSpeedPoint runTSTunerTest(int i) {
-  auto &bot = getRobot();
-  auto &ctrl = bot.controller;
-  line_set(0, "TrueSpeed Tuner");
-  line_set(1, "A: ready for");
-  line_set(2, std::to_string(i) + "mV test.");
-  while(!ctrl.get_digital_new_press(DIGITAL_A)) {
-    bot.base->arcade(ctrl.get_analog(ANALOG_LEFT_Y) / 127.0, ctrl.get_analog(ANALOG_LEFT_X) / 127.0);
-    pros::delay(5);
-  }
-  //Get starting position
-  double start = bot.left.getPosition();
-  //Go!
-  bot.left .moveVoltage(i);
-  bot.right.moveVoltage(i);
-  //Record time
-  auto testStartTime = pros::millis();
-  //Wait for error to be over 80in, or for a second to pass with no motion
-  while(bot.gps.countsToInch(std::abs(start - bot.left.getPosition())) < 80 &&
-  !(testStartTime + 1000 < pros::millis() && !bot.left.getActualVelocity())) {
-    pros::delay(5);
-  }
-  //Measure final velocity
-  double vel = (bot.left.getActualVelocity() + bot.right.getActualVelocity()) / 2.0;
-  //Stop the robot
-  bot.left.moveVelocity(0);
-  bot.right.moveVelocity(0);
-  //Record the point to terminal & ts
-  printf("%dmV: %frpam\n", i, vel);
-  //Velocity first! Both should be from 0 to 1.
-  return {vel / (double)bot.left.getGearing(), i / 12000.0};
-}
-
-void truespeedTuner() {
-  auto &bot = getRobot();
-  std::vector<TrueSpeedPoint> ts = {{0, 0}};
-  //Binary Search for Minimum Voltage
-  //Making sure the minimum voltage to achieve motion is recorded
-  //ensures that any RPM value given will always move the robot.
-  int minVoltageLowBound = 0;
-  int minVoltageHighBound = 1000;
-  TrueSpeedPoint mvpt;
-  while(minVoltageLowBound + 1 != minVoltageHighBound) {
-    auto attempt = (minVoltageHighBound + minVoltageLowBound) / 2;
-    auto pt = runTSTunerTest(attempt);
-    if(pt.x > 0) {
-      //Update the high bound to the value tried.
-      minVoltageHighBound = attempt;
-      mvpt = pt;
-    } else {
-      //Update the low bound to the value tried.
-      minVoltageLowBound = attempt;
-    }
+//Runs characterizeDrive() with messages on-screen, and offers to save the results.
+class DriveCharacterizer: public ControllerMenu {
+  public:
+  DriveCharacterizer() {}
+  void render() override {
+    line_set(0, "Give bot 36in");
+    line_set(1, "space fwd/rev");
+    line_set(2, "then press A.");
   }
-  ts.push_back(mvpt);
-  for(int i = 1000; i <= 12000; i += 1000) {
-    auto p = runTSTunerTest(i);
-    //If the vel is already on the list, don't add a duplicate!
-    if(std::find_if(ts.begin(), ts.end(), [&p, &bot](const TrueSpeedPoint& p2) {
-      return p.x == p2.x;
-    }) == ts.end()) {
-      ts.push_back(p);
+  int checkController() override {
+    auto &ctrl = menuInput();
+    if(ctrl.newPress(DIGITAL_B)) return GO_UP;
+    if(ctrl.newPress(DIGITAL_A)) {
+      SysIdResult result;
+      bool finished = false;
+      runJob("Characterizing", [&]() {
+        finished = characterizeDrive(result);
+      });
+      if(!finished) {
+        line_set(0, "Aborted.");
+        line_set(1, "");
+        line_set(2, "");
+        pros::delay(1000);
+        return GO_UP;
+      }
+      char buf[3][32];
+      snprintf(buf[0], sizeof(buf[0]), "kS%.0f kV%.2f", result.feedforward.kS, result.feedforward.kV);
+      snprintf(buf[1], sizeof(buf[1]), "kA%.3f r2 %.2f", result.feedforward.kA, result.rSquared);
+      snprintf(buf[2], sizeof(buf[2]), "A: save B: drop");
+      for(int i = 0; i < 3; i++) line_set(i, buf[i]);
+      while(true) {
+        if(ctrl.newPress(DIGITAL_B)) break;
+        if(ctrl.newPress(DIGITAL_A)) {
+          auto &set = getRobot().baseSettings;
+          auto ff = set.getFeedforward();
+          ff.kS = result.feedforward.kS;
+          ff.kV = result.feedforward.kV;
+          ff.kA = result.feedforward.kA;
+          //Leave headroom for the PIDs to correct with.
+          if(ff.maxVelocity <= 0 || ff.maxVelocity > 0.9 * result.topSpeed) {
+            ff.maxVelocity = 0.9 * result.topSpeed;
+          }
+          set.setFeedforward(ff);
+          if(result.trueSpeed.size() >= 2) {
+            set.setTrueSpeedData(result.trueSpeed);
+          }
+          break;
+        }
+        ctrl.wait(menuWaitTimeout);
+      }
+      return GO_UP;
     }
+    return NO_CHANGE;
   }
-  std::sort(ts.begin(), ts.end(), [](const TrueSpeedPoint& p1, const TrueSpeedPoint& p2) {
-    return p1.x < p2.x;
-  });
-  //Push new ts values to base settings.
-  bot.baseSettings.setTrueSpeedData(ts);
-}
+};
 
 //Contains TrueSpeed menus
 class TSList: public ControllerMenu {
@@ -1118,13 +1750,65 @@ class TSList: public ControllerMenu {
           printf("%f,%f\n", pt.x, pt.y);
         }
       }},
-      {"Tune TS Data", [&]() {
-        truespeedTuner();
+      {"Characterize", taskOption<DriveCharacterizer>},
+      {"TS Smoothing", [&]() {
+        getRobot().baseSettings.setTrueSpeedSmoothing(
+          selectOption({"Linear", "Monotone cubic"}, getRobot().baseSettings.getTrueSpeedSmoothing() ? 1 : 0)
+        );
+      }},
+      {"TS Benchmark", [&]() {
+        line_set(0, "Benchmarking,");
+        line_set(1, "results go to");
+        line_set(2, "the terminal.");
+        trueSpeedBenchmark();
       }}
     });
   }
 };
 
+//Runs moveBenchmark() with messages on-screen.
+class MoveBenchmarker: public ControllerMenu {
+  public:
+  MoveBenchmarker() {}
+  void render() override {
+    line_set(0, "Give bot 48in");
+    line_set(1, "space fwd/rev");
+    line_set(2, "then press A.");
+  }
+  int checkController() override {
+    auto &ctrl = menuInput();
+    if(ctrl.newPress(DIGITAL_B)) return GO_UP;
+    if(ctrl.newPress(DIGITAL_A)) {
+      std::vector<MoveResult> results;
+      bool finished = false;
+      runJob("Benchmarking", [&]() {
+        finished = moveBenchmark(results);
+      });
+      if(!finished) {
+        line_set(0, "Aborted.");
+        line_set(1, "");
+        line_set(2, "");
+        pros::delay(1000);
+        return GO_UP;
+      }
+      uint32_t totalSettle = 0;
+      double worstOvershoot = 0;
+      for(auto &r: results) {
+        totalSettle += r.settleTime;
+        worstOvershoot = std::max(worstOvershoot, r.overshoot);
+      }
+      line_set(0, "Set " + gainSetKey());
+      line_set(1, "avg sT " + std::to_string(totalSettle / std::max<size_t>(results.size(), 1)) + "ms");
+      char buf[32];
+      snprintf(buf, sizeof(buf), "max OS %.1f%%", worstOvershoot);
+      line_set(2, buf);
+      while(!ctrl.newPress(DIGITAL_B)) ctrl.wait(menuWaitTimeout);
+      return GO_UP;
+    }
+    return NO_CHANGE;
+  }
+};
+
 //Contains GPS menus & cpr/cpi editors.
 class GPSList: public ControllerMenu {
   public:
@@ -1133,8 +1817,14 @@ class GPSList: public ControllerMenu {
     list.insert(list.end(), {
       {"Calibrate GPS", taskOption<GPSCalibrator>},
       {"Set Position", taskOption<GPSPositionList>},
+      {"Drive Health", taskOption<DriveHealthList>},
       {"Set Gains", taskOption<GPSGainList>},
       {"Tune Gains", taskOption<GainTuner>},
+      {"Move Benchmark", taskOption<MoveBenchmarker>},
+      {"Tune Rule", [&]() {
+        auto &set = getRobot().baseSettings;
+        set.setTuningRule((TuningRule)selectOption(tuningRuleNames(), (int)set.getTuningRule()));
+      }},
       {"Set CPR", [&]() {
         gps.setCPR(editNumber(gps.radiansToCounts(1), 4));
       }},
@@ -1146,14 +1836,72 @@ class GPSList: public ControllerMenu {
           selectOption({"Nahhhhh", "Yesssss"}, getRobot().baseSettings.getVoltagePIDUsage() ? 1 : 0)
         );
       }},
+      {"Battery Comp", [&]() {
+        getRobot().baseSettings.setBatteryCompensationUsage(
+          selectOption({"Off", "On"}, getRobot().baseSettings.getBatteryCompensationUsage() ? 1 : 0)
+        );
+      }},
       {"TS Settings", taskOption<TSList>},
+      {"Loop Period", [&]() {
+        auto &set = getRobot().baseSettings;
+        //Outside this range the telemetry daemon can't keep up, or odometry drifts between ticks.
+        const double period = std::clamp(editNumber(set.getLoopPeriod(), 0), (double)minTelemetryPeriod, (double)maxTelemetryPeriod);
+        set.setLoopPeriod((int)period);
+      }},
+      {"Loop Stats", [&]() {
+        auto &ctrl = menuInput();
+        uint32_t lastTime = 0;
+        line_set(0, "A: reset, B: exit");
+        while(!ctrl.newPress(DIGITAL_B)) {
+          auto &base = *getRobot().base;
+          if(ctrl.newPress(DIGITAL_A)) {
+            base.resetLoopStats();
+          }
+          if(pros::millis() - lastTime >= 500) {
+            auto &stats = base.getLoopStats();
+            char buf[3][32];
+            snprintf(buf[0], sizeof(buf[0]), "p%dms ovr %u", (int)base.getLoopPeriod().convert(millisecond), (unsigned)stats.overruns.load());
+            snprintf(buf[1], sizeof(buf[1]), "exec %u/%ums", (unsigned)stats.execTime.load(), (unsigned)stats.maxExecTime.load());
+            snprintf(buf[2], sizeof(buf[2]), "jit %u/%ums", (unsigned)stats.jitter.load(), (unsigned)stats.maxJitter.load());
+            line_set(0, buf[0]);
+            line_set(1, buf[1]);
+            line_set(2, buf[2]);
+            lastTime = pros::millis();
+          }
+          ctrl.wait(menuWaitTimeout);
+        }
+      }},
+      {"Loop Allocs", [&]() {
+        auto &ctrl = menuInput();
+        uint32_t lastCount = getWatchedAllocations();
+        uint32_t lastTime = pros::millis();
+        line_set(0, "Base loop allocs");
+        line_set(1, "measuring...");
+        line_set(2, "B to dismiss");
+        while(!ctrl.newPress(DIGITAL_B)) {
+          if(pros::millis() - lastTime >= 1000) {
+            uint32_t count = getWatchedAllocations();
+            line_set(1, "total: " + std::to_string(count));
+            line_set(2, "last 1s: " + std::to_string(count - lastCount));
+            lastCount = count;
+            lastTime = pros::millis();
+          }
+          ctrl.wait(menuWaitTimeout);
+        }
+      }},
+      {"Odom Benchmark", [&]() {
+        line_set(0, "Benchmarking,");
+        line_set(1, "results go to");
+        line_set(2, "the terminal.");
+        odometryBenchmark(gps.radiansToCounts(1), gps.inchToCounts(1));
+      }},
       {"Fwd Drive Test", [&]() {
-        auto &ctrl = getRobot().controller;
+        auto &ctrl = menuInput();
         line_set(0, "Now driving.");
         line_set(1, "Only fwd/back");
         line_set(2, "B to dismiss");
-        while(!ctrl.get_digital_new_press(DIGITAL_B)) {
-          getRobot().base->driveVector(ctrl.get_analog(ANALOG_LEFT_Y) / 127.0, 0);
+        while(!ctrl.newPress(DIGITAL_B)) {
+          getRobot().base->driveVector(ctrl.analog(ANALOG_LEFT_Y) / 127.0, 0);
           pros::delay(5);
         }
       }}
@@ -1193,6 +1941,9 @@ class RootList: public ControllerMenu {
       {"Motors"        , taskOption<MotorList>},
       {"GPS Settings"  , taskOption<  GPSList>},
       {"Punch Settings", taskOption<PunchList>},
+      {"Dashboard"     , taskOption<DashboardMenu>},
+      {"Strip Charts"  , taskOption<StripChartMenu>},
+      {"Save Stats"    , taskOption<SaveStatsMenu>},
       {"Dump Data", [&]() {
         puts((getState().dump() + "\n").c_str());
       }}
@@ -1204,26 +1955,42 @@ class RootList: public ControllerMenu {
 void drawCatOSScreen() {
   line_set(0, "catOS v1.3");
   line_set(1, "press <-+-> to");
-  line_set(2, "activate menu");
+  line_set(2, getRobot().driveMonitor.hasFault() ? "DRIVE FAULT!" : "activate menu");
 }
 
 //The background task that controls controller UI.
 void catOS(void*) {
-  pros::Controller ctrl(pros::E_CONTROLLER_MASTER);
+  auto &ctrl = menuInput();
   drawCatOSScreen();
+  bool lastDriveFault = false;
   while(true) {
-    if(ctrl.get_digital(DIGITAL_LEFT) && ctrl.get_digital(DIGITAL_RIGHT)) {
+    //Let the user know when a base motor has faulted.
+    bool driveFault = getRobot().driveMonitor.hasFault();
+    if(driveFault != lastDriveFault) {
+      lastDriveFault = driveFault;
+      drawCatOSScreen();
+    }
+    if(ctrl.held(DIGITAL_LEFT) && ctrl.held(DIGITAL_RIGHT)) {
       getRobot().takeStopped();
       menuWasEntered = true;
+      //The presses that opened the menu aren't meant for it.
+      ctrl.clear();
       RootList()();
       drawCatOSScreen();
       getRobot().give();
       menuWasEntered = false;
     }
+    //The dashboard doesn't take the robot, so opcontrol keeps driving.
+    if(ctrl.held(DIGITAL_UP) && ctrl.held(DIGITAL_DOWN)) {
+      while(ctrl.held(DIGITAL_UP) || ctrl.held(DIGITAL_DOWN)) pros::delay(25);
+      ctrl.clear();
+      Dashboard(true).runFromHome();
+      drawCatOSScreen();
+    }
     if(checkBattery(ctrl)) {
       drawCatOSScreen();
     }
-    pros::delay(5);
+    ctrl.wait(menuWaitTimeout);
   }
 }
 
@@ -1,5 +1,15 @@
 #pragma once
 #include <string>
+#include "display/lvgl.h"
 
 std::string getSelectedAuton();
 void startupDisplay();
+
+/**
+ * Creates the field map of colored tiles used on the brain screen.
+ * The tiles don't take touches, so the field gets them.
+ *
+ * @param parent Object to create the field in
+ * @param size   Width & height of the field, in pixels
+ */
+lv_obj_t* createField(lv_obj_t* parent, lv_coord_t size);
@@ -0,0 +1,207 @@
+/**
+ * @file driveMonitor.cpp
+ *
+ * This file defines the DriveMonitor, which watches the individual motors
+ * inside the base's MotorGroups for slip & encoder faults.
+ */
+#include "main.h"
+#include "driveMonitor.hpp"
+#include "telemetry.hpp"
+#include <algorithm>
+#include <cmath>
+
+///Velocity difference, in RPM, between a motor and the rest of its side that counts as divergence.
+const double divergenceThreshold = 12.5;
+///How long, in ms, a motor must look diverged before it is flagged.
+const uint32_t divergenceTime = 300;
+///How long, in ms, a motor must be unreadable before it is flagged.
+const uint32_t disconnectTime = 50;
+///Most motors on one side of the base that will be monitored.
+const int maxMotorsPerSide = 8;
+
+/**
+ * An encoder that reads a side's position from a DriveMonitor, so
+ * faulted motors are ignored.
+ */
+class MonitoredEncoder: public okapi::ContinuousRotarySensor {
+  DriveMonitor& monitor;
+  DriveMonitor::Side side;
+  double offset = 0;
+  public:
+  MonitoredEncoder(DriveMonitor& imonitor, DriveMonitor::Side iside): monitor(imonitor), side(iside) {}
+  double get() const override { return monitor.getPosition(side) - offset; }
+  std::int32_t reset() override { offset = monitor.getPosition(side); return 1; }
+  double controllerGet() override { return get(); }
+};
+
+std::string faultName(DriveMonitor::Fault fault) {
+  switch(fault) {
+    case DriveMonitor::HEALTHY:      return "ok";
+    case DriveMonitor::DISCONNECTED: return "DISC";
+    case DriveMonitor::DIVERGED:     return "SLIP";
+  }
+  return "?";
+}
+
+DriveMonitor::DriveMonitor(std::initializer_list<int> leftPorts, std::initializer_list<int> rightPorts, pros::Controller& icontroller):
+controller(icontroller) {
+  for(int port: leftPorts) {
+    motors.push_back({okapi::Motor((std::int8_t)port), port, LEFT, HEALTHY, 0, false, 0});
+  }
+  for(int port: rightPorts) {
+    motors.push_back({okapi::Motor((std::int8_t)port), port, RIGHT, HEALTHY, 0, false, 0});
+  }
+  for(auto &tracked: motors) {
+    tracked.motor.setGearing(okapi::AbstractMotor::gearset::green);
+    tracked.motor.setEncoderUnits(okapi::AbstractMotor::encoderUnits::degrees);
+  }
+}
+
+void DriveMonitor::update(const TelemetrySnapshot& snapshot) {
+  uint32_t now = pros::millis();
+  bool newFault = false;
+  //Every motor is read from the same telemetry tick, rather than one device call at a time.
+  lock.take(TIMEOUT_MAX);
+  for(Side side: {LEFT, RIGHT}) {
+    //Motors on this side that could be read this tick, with their velocity & current.
+    struct Reading { Tracked* tracked; double delta; double velocity; int32_t current; };
+    Reading readings[maxMotorsPerSide];
+    int readingCount = 0;
+    for(auto &tracked: motors) {
+      if(tracked.side != side || readingCount == maxMotorsPerSide) continue;
+      auto &sample = snapshot.motor(tracked.port);
+      double pos = sample.position;
+      double vel = sample.velocity;
+      if(!sample.valid || !std::isfinite(pos) || !std::isfinite(vel)) {
+        //Unreadable, the motor is probably unplugged.
+        tracked.hasLast = false;
+        if(!tracked.suspectSince) tracked.suspectSince = now;
+        if(tracked.fault == HEALTHY && now - tracked.suspectSince >= disconnectTime) {
+          tracked.fault = DISCONNECTED;
+          newFault = true;
+          printf("DriveMonitor: motor %d disconnected\n", tracked.port);
+        }
+        continue;
+      }
+      readings[readingCount++] = {&tracked, tracked.hasLast ? pos - tracked.lastPosition : 0.0, vel, sample.current};
+      tracked.lastPosition = pos;
+      tracked.hasLast = true;
+    }
+
+    //Find the motor disagreeing most with the rest of its side.
+    Tracked* suspect = nullptr;
+    if(readingCount > 2) {
+      double velocities[maxMotorsPerSide];
+      for(int i = 0; i < readingCount; i++) velocities[i] = readings[i].velocity;
+      std::nth_element(velocities, velocities + readingCount / 2, velocities + readingCount);
+      double median = velocities[readingCount / 2];
+      auto worst = std::max_element(readings, readings + readingCount, [median](const Reading& a, const Reading& b) {
+        return std::abs(a.velocity - median) < std::abs(b.velocity - median);
+      });
+      if(std::abs(worst->velocity - median) > divergenceThreshold) suspect = worst->tracked;
+    } else if(readingCount == 2) {
+      auto *fast = &readings[0], *slow = &readings[1];
+      if(std::abs(fast->velocity) < std::abs(slow->velocity)) std::swap(fast, slow);
+      if(std::abs(fast->velocity - slow->velocity) > 2 * divergenceThreshold) {
+        //A stripped motor spins freely, so it runs faster on less current. Otherwise,
+        //the slow motor's encoder is the one that isn't keeping up.
+        suspect = fast->current < slow->current ? fast->tracked : slow->tracked;
+      }
+    }
+    for(int i = 0; i < readingCount; i++) {
+      auto &tracked = *readings[i].tracked;
+      if(&tracked != suspect) {
+        tracked.suspectSince = 0;
+        continue;
+      }
+      if(!tracked.suspectSince) tracked.suspectSince = now;
+      if(tracked.fault == HEALTHY && now - tracked.suspectSince >= divergenceTime) {
+        tracked.fault = DIVERGED;
+        newFault = true;
+        printf("DriveMonitor: motor %d diverged from its side\n", tracked.port);
+      }
+    }
+
+    //Average the healthy motors' travel, velocity & current into the side's.
+    double sum = 0, allSum = 0, velocitySum = 0, allVelocitySum = 0, currentSum = 0, allCurrentSum = 0;
+    int count = 0;
+    for(int i = 0; i < readingCount; i++) {
+      allSum += readings[i].delta;
+      allVelocitySum += readings[i].velocity;
+      allCurrentSum += readings[i].current;
+      if(readings[i].tracked->fault == HEALTHY) {
+        sum += readings[i].delta;
+        velocitySum += readings[i].velocity;
+        currentSum += readings[i].current;
+        count++;
+      }
+    }
+    if(count) {
+      position[side] += sum / count;
+      velocity[side] = velocitySum / count;
+      current[side] = currentSum / count;
+    } else if(readingCount) {
+      position[side] += allSum / readingCount;
+      velocity[side] = allVelocitySum / readingCount;
+      current[side] = allCurrentSum / readingCount;
+    }
+  }
+  lock.give();
+  if(newFault) {
+    controller.rumble("---");
+  }
+}
+
+double DriveMonitor::getPosition(Side side) {
+  lock.take(TIMEOUT_MAX);
+  double ret = position[side];
+  lock.give();
+  return ret;
+}
+
+double DriveMonitor::getVelocity(Side side) {
+  lock.take(TIMEOUT_MAX);
+  double ret = velocity[side];
+  lock.give();
+  return ret;
+}
+
+double DriveMonitor::getCurrent(Side side) {
+  lock.take(TIMEOUT_MAX);
+  double ret = current[side];
+  lock.give();
+  return ret;
+}
+
+std::vector<DriveMonitor::MotorStatus> DriveMonitor::getStatus() {
+  std::vector<MotorStatus> ret;
+  lock.take(TIMEOUT_MAX);
+  for(auto &tracked: motors) {
+    ret.push_back({tracked.port, tracked.side, tracked.fault});
+  }
+  lock.give();
+  return ret;
+}
+
+bool DriveMonitor::hasFault() {
+  bool ret = false;
+  lock.take(TIMEOUT_MAX);
+  for(auto &tracked: motors) {
+    if(tracked.fault != HEALTHY) ret = true;
+  }
+  lock.give();
+  return ret;
+}
+
+void DriveMonitor::clearFaults() {
+  lock.take(TIMEOUT_MAX);
+  for(auto &tracked: motors) {
+    tracked.fault = HEALTHY;
+    tracked.suspectSince = 0;
+  }
+  lock.give();
+}
+
+std::shared_ptr<okapi::ContinuousRotarySensor> DriveMonitor::getEncoder(Side side) {
+  return std::make_shared<MonitoredEncoder>(*this, side);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file driveMonitor.hpp
+ *
+ * This file declares the DriveMonitor, which watches the individual motors
+ * inside the base's MotorGroups for slip & encoder faults.
+ */
+#pragma once
+#include "main.h"
+#include "okapi/api.hpp"
+#include "telemetry.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * DriveMonitor compares the position, velocity and current of every motor
+ * on each side of the base. A motor that can't be read, or whose velocity
+ * keeps disagreeing with the rest of its side, is flagged and excluded from
+ * the side's position. Odometry and the base's PID both read positions from
+ * here, so one bad motor can't quietly skew either of them.
+ *
+ * Faults latch until clearFaults() is called. update() is run by the
+ * telemetry daemon on each snapshot just before it's published, and reads
+ * from that snapshot rather than the motors themselves.
+ *
+ * @see GPS
+ */
+class DriveMonitor {
+  public:
+  ///Side of the base a motor drives.
+  enum Side {
+    LEFT  = 0, ///< Left side of the base
+    RIGHT = 1  ///< Right side of the base
+  };
+  ///Health of a single motor.
+  enum Fault {
+    HEALTHY = 0,  ///< Motor agrees with the rest of its side
+    DISCONNECTED, ///< Motor can't be read
+    DIVERGED      ///< Motor's velocity disagrees with the rest of its side
+  };
+  ///Status of a single motor, as reported by getStatus().
+  struct MotorStatus {
+    int port;
+    Side side;
+    Fault fault;
+  };
+
+  /**
+   * Constructs a DriveMonitor from the ports of each side of the base.
+   * These should match the ports of the base's MotorGroups.
+   *
+   * @param leftPorts  Ports of the left side's motors, negative if reversed
+   * @param rightPorts Ports of the right side's motors, negative if reversed
+   * @param controller Controller to rumble when a fault is detected
+   */
+  DriveMonitor(std::initializer_list<int> leftPorts, std::initializer_list<int> rightPorts, pros::Controller& controller);
+
+  /**
+   * Reads every motor from a telemetry snapshot, updating faults & side positions.
+   *
+   * @param snapshot Snapshot of the tick being published
+   */
+  void update(const TelemetrySnapshot& snapshot);
+
+  /**
+   * Gets the position of a side in encoder degrees, accumulated only from
+   * motors that are currently healthy. If every motor on a side is faulted,
+   * all readable motors are used instead.
+   *
+   * @param side Side to get the position of
+   */
+  double getPosition(Side side);
+
+  /**
+   * Gets the velocity of a side in RPM, averaged over the same motors as
+   * getPosition(side).
+   *
+   * @param side Side to get the velocity of
+   */
+  double getVelocity(Side side);
+
+  /**
+   * Gets the average current draw of a side's motors in mA, over the same
+   * motors as getPosition(side).
+   *
+   * @param side Side to get the current of
+   */
+  double getCurrent(Side side);
+
+  ///Gets the health of every monitored motor.
+  std::vector<MotorStatus> getStatus();
+
+  ///Whether any motor is currently faulted.
+  bool hasFault();
+
+  ///Marks every motor as healthy again.
+  void clearFaults();
+
+  /**
+   * Gets an encoder reading from getPosition(side), so controllers can
+   * ignore faulted motors too.
+   *
+   * @param side Side the encoder should read
+   */
+  std::shared_ptr<okapi::ContinuousRotarySensor> getEncoder(Side side);
+
+  private:
+  ///Bookkeeping for one monitored motor.
+  struct Tracked {
+    okapi::Motor motor;
+    int port;
+    Side side;
+    Fault fault;
+    ///Position at the last readable sample.
+    double lastPosition;
+    ///Whether lastPosition is valid.
+    bool hasLast;
+    ///Time this motor started looking faulty, or 0 if it looks fine.
+    uint32_t suspectSince;
+  };
+  std::vector<Tracked> motors;
+  ///Accumulated position of each side.
+  double position[2] = {0, 0};
+  ///Velocity of each side at the last update.
+  double velocity[2] = {0, 0};
+  ///Average current draw of each side at the last update.
+  double current[2] = {0, 0};
+  ///Guards \ref motors, \ref position, \ref velocity and \ref current.
+  pros::Mutex lock;
+  pros::Controller& controller;
+};
+
+///Short display name for a fault, at most 5 characters.
+std::string faultName(DriveMonitor::Fault fault);
@@ -52,10 +52,10 @@ void renderStringEditor(std::string& text, int cursor) {
 
 //Edit number using controller LCD & input
 double editNumber(double number, int fix) {
-  auto &ctrl = getRobot().controller;
+  auto &ctrl = menuInput();
   int cursor = 14 - fix - (fix > 0);
   renderNumberEditor(number, fix, cursor);
-  while(!ctrl.get_digital_new_press(DIGITAL_A) && !ctrl.get_digital_new_press(DIGITAL_B)) {
+  while(!ctrl.newPress(DIGITAL_A) && !ctrl.newPress(DIGITAL_B)) {
     //Cursor Movement
     int hdir = getHorizontalDirection();
     cursor += hdir;
@@ -90,13 +90,13 @@ double editNumber(double number, int fix) {
     }
 
     //Floor button
-    if(ctrl.get_digital_new_press(DIGITAL_X)) {
+    if(ctrl.newPress(DIGITAL_X)) {
       number = std::floor(number);
       renderNumberEditor(number, fix, cursor);
     }
 
-    //Loop delay
-    pros::delay(5);
+    //Wait for the next press
+    ctrl.wait(menuWaitTimeout);
   }
   return number;
 }
@@ -116,11 +116,11 @@ void unrightPad(std::string& str) {
 
 //Edit text using controller LCD & input
 std::string editString(std::string text) {
-  auto &ctrl = getRobot().controller;
+  auto &ctrl = menuInput();
   int cursor = 0;
   text.insert(text.size(), 15 - text.size(), ' ');
   renderStringEditor(text, cursor);
-  while(!ctrl.get_digital_new_press(DIGITAL_A) && !ctrl.get_digital_new_press(DIGITAL_B)) {
+  while(!ctrl.newPress(DIGITAL_A) && !ctrl.newPress(DIGITAL_B)) {
     //Cursor Movement
     int hdir = getHorizontalDirection();
     cursor += hdir;
@@ -174,32 +174,32 @@ std::string editString(std::string text) {
     //Re-render if symbol was changed
     if(vdir) renderStringEditor(text, cursor);
 
-    //Loop delay
-    pros::delay(5);
+    //Wait for the next press
+    ctrl.wait(menuWaitTimeout);
   }
   unrightPad(text);
   return text;
 }
 
 //Select option from list using controller LCD & input
-int selectOption(std::initializer_list<std::string> list, int idx) {
-  auto &ctrl = getRobot().controller;
+int selectOption(const std::vector<std::string>& list, int idx) {
+  auto &ctrl = menuInput();
   renderEditorArrows(0);
-  line_set(1, list.begin()[idx]);
+  line_set(1, list[idx]);
   while(true) {
     //Option Changing
     int vdir = getVerticalDirection();
     idx += vdir;
     bound(idx, list.size());
-    if(vdir) line_set(1, list.begin()[idx]);
+    if(vdir) line_set(1, list[idx]);
 
     //Option Selection
-    if(ctrl.get_digital_new_press(DIGITAL_B) || ctrl.get_digital_new_press(DIGITAL_A)) {
+    if(ctrl.newPress(DIGITAL_B) || ctrl.newPress(DIGITAL_A)) {
       break;
     }
 
-    //Loop delay
-    pros::delay(5);
+    //Wait for the next press
+    ctrl.wait(menuWaitTimeout);
   }
   return idx;
 }
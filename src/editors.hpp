@@ -31,4 +31,4 @@ std::string editString(std::string text);
  * @param idx  Index of first shown option
  * @return Index selected by user
  */
-int selectOption(std::initializer_list<std::string> list, int idx);
+int selectOption(const std::vector<std::string>& list, int idx);
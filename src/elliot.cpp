@@ -11,17 +11,29 @@
 #include "state.hpp"
 #include "json.hpp"
 #include "autoshoot.hpp"
+#include "battery.hpp"
+#include "telemetry.hpp"
 #include <deque>
 using namespace okapi;
 
+std::shared_ptr<okapi::AsyncPosPIDController> Puncher::controller() {
+    controllerLock.take(TIMEOUT_MAX);
+    auto ret = controllerPtr;
+    controllerLock.give();
+    return ret;
+}
+
 void Puncher::loadState() {
     double oldTarget = 0;
     bool oldDisabled = true;
-    if(controllerPtr) {
-        oldTarget = controllerPtr->getTarget();
-        oldDisabled = controllerPtr->isDisabled();
+    auto old = controller();
+    if(old) {
+        oldTarget = old->getTarget();
+        oldDisabled = old->isDisabled();
+        //puncherTask() may keep the old controller alive for a moment, so it mustn't fight the new one.
+        old->flipDisable(true);
     }
-    controllerPtr = std::make_shared<okapi::AsyncPosPIDController>(
+    auto replacement = std::make_shared<okapi::AsyncPosPIDController>(
         std::make_shared<Potentiometer>(angleSense),
         std::make_shared<MotorGroup>(angler),
         okapi::TimeUtilFactory::create(),
@@ -29,37 +41,56 @@ void Puncher::loadState() {
         puncherData["kI"].get<double>(),
         puncherData["kD"].get<double>()
     );
-    controllerPtr->flipDisable(oldDisabled);
-    controllerPtr->setTarget(oldTarget);
-    controllerPtr->startThread();
+    replacement->flipDisable(oldDisabled);
+    replacement->setTarget(oldTarget);
+    replacement->startThread();
+    controllerLock.take(TIMEOUT_MAX);
+    controllerPtr = replacement;
+    controllerLock.give();
      lowTargetPosition = puncherData["low" ].get<double>();
     highTargetPosition = puncherData["high"].get<double>();
 }
 
-Puncher::Puncher(MotorGroup& ipuncher, MotorGroup& iangler, okapi::Potentiometer& iangleSense, json& ipuncherData):
-puncher(ipuncher), angler(iangler), angleSense(iangleSense), puncherData(ipuncherData) {
+Puncher::Puncher(MotorGroup& ipuncher, int ipuncherPort, MotorGroup& iangler, int ianglerPort, okapi::Potentiometer& iangleSense, json& ipuncherData):
+puncher(ipuncher), puncherPort(ipuncherPort), angler(iangler), anglerPort(ianglerPort), angleSense(iangleSense), puncherData(ipuncherData) {
     puncherTarget = ipuncher.getPosition();
     loadState();
 }
 
 void Puncher::puncherTask() {
+    TelemetrySnapshot snapshot;
+    //Full angler speed, in degrees per second, to trace PID output as a velocity.
+    const double outputToVelocity = toUnderlyingType(angler.getGearing()) * 6.0;
+    uint32_t lastTraced = 0;
     while(true) {
-        if(abs(puncher.getPosition() - puncher.getTargetPosition()) < 20 && puncher.getActualVelocity() < 5) {
+        getTelemetry(snapshot);
+        auto &sample = snapshot.motor(puncherPort);
+        if(sample.valid && abs(sample.position - puncher.getTargetPosition()) < 20 && sample.velocity < 5) {
             puncher.moveVoltage(0);
         }
+        //Trace the angler once per telemetry tick, while its PID is driving it.
+        auto &anglerSample = snapshot.motor(anglerPort);
+        auto anglerPID = controller();
+        if(anglerSample.valid && snapshot.tick != lastTraced && !anglerPID->isDisabled()) {
+            lastTraced = snapshot.tick;
+            trace.push({snapshot.time, (float)anglerPID->getError(), (float)(anglerPID->getOutput() * outputToVelocity),
+                        (float)(anglerSample.velocity * 6), (float)anglerSample.current});
+        }
         pros::delay(5);
     }
 }
 void Puncher::lowTarget() {
-    controllerPtr->setTarget(lowTargetPosition);
-    controllerPtr->flipDisable(false);
+    auto anglerPID = controller();
+    anglerPID->setTarget(lowTargetPosition);
+    anglerPID->flipDisable(false);
 }
 void Puncher::highTarget() {
-    controllerPtr->setTarget(highTargetPosition);
-    controllerPtr->flipDisable(false);
+    auto anglerPID = controller();
+    anglerPID->setTarget(highTargetPosition);
+    anglerPID->flipDisable(false);
 }
 void Puncher::stopAutoControl() {
-    controllerPtr->flipDisable(true);
+    controller()->flipDisable(true);
 }
 void Puncher::shoot() {
     puncherTarget -= 360;
@@ -69,26 +100,28 @@ void Puncher::setVelocity(double vel) {
     puncher.moveVelocity(vel);
 }
 int Puncher::targetError() {
-    return controllerPtr->getError();
+    return controller()->getError();
 }
 void Puncher::toggleTarget() {
-    if(controllerPtr->getTarget() == lowTargetPosition) {
+    if(controller()->getTarget() == lowTargetPosition) {
         highTarget();
     } else {
         lowTarget();
     }
 }
 void Puncher::setLowTarget(int target) {
-    if(controllerPtr->getTarget() == lowTargetPosition) {
-        controllerPtr->setTarget(target);
+    auto anglerPID = controller();
+    if(anglerPID->getTarget() == lowTargetPosition) {
+        anglerPID->setTarget(target);
     }
     lowTargetPosition = target;
     puncherData["low"] = target;
     saveState();
 }
 void Puncher::setHighTarget(int target) {
-    if(controllerPtr->getTarget() == highTargetPosition) {
-        controllerPtr->setTarget(target);
+    auto anglerPID = controller();
+    if(anglerPID->getTarget() == highTargetPosition) {
+        anglerPID->setTarget(target);
     }
     highTargetPosition = target;
     puncherData["high"] = target;
@@ -153,7 +186,46 @@ json& getBaseState() {
             {"kI", 0},
             {"kD", 0},
         }},
-        {"voltage", false}
+        {"schedule", {
+            {"dist", json::array()},
+            {"angle", json::array()},
+            {"turn", json::array()}
+        }},
+        {"pidOpts", {
+            {"dist", {
+                {"filter", "None"},
+                {"alpha", 1},
+                {"iLimit", 1},
+                {"iBand", 0},
+                {"iReset", false}
+            }},
+            {"angle", {
+                {"filter", "None"},
+                {"alpha", 1},
+                {"iLimit", 1},
+                {"iBand", 0},
+                {"iReset", false}
+            }},
+            {"turn", {
+                {"filter", "None"},
+                {"alpha", 1},
+                {"iLimit", 1},
+                {"iBand", 0},
+                {"iReset", false}
+            }}
+        }},
+        {"voltage", false},
+        {"batteryComp", true},
+        {"ff", {
+            {"kS", 0},
+            {"kV", 0},
+            {"kA", 0},
+            {"maxVel", 900},
+            {"maxAccel", 1800}
+        }},
+        {"tsSmooth", false},
+        {"tuneRule", "Some overshoot"},
+        {"period", 10}
     });
     return getState()["base"];
 }
@@ -174,17 +246,19 @@ pros::Mutex Elliot::usageGuard;
 Elliot::Elliot():
 controller{CONTROLLER_MASTER},
 partner   {CONTROLLER_MASTER},
-left{12, 1},
-right{-3, -4},
-puncherMtr{5},
-angler{8},
-intake{10},
-scorer{6},
+left{motorPorts::left1, motorPorts::left2},
+right{motorPorts::right1, motorPorts::right2},
+puncherMtr{motorPorts::puncher},
+angler{motorPorts::angler},
+intake{motorPorts::intake},
+scorer{motorPorts::scorer},
 angleSense{'A'},
-puncher{puncherMtr, angler, angleSense, getPuncherState()},
-gps{left, right, getGPSState()},
+puncher{puncherMtr, motorPorts::puncher, angler, motorPorts::angler, angleSense, getPuncherState()},
+driveMonitor{{motorPorts::left1, motorPorts::left2}, {motorPorts::right1, motorPorts::right2}, controller},
+gps{left, right, driveMonitor, getGPSState()},
 base{nullptr},
 baseSettings{left, right,
+driveMonitor.getEncoder(DriveMonitor::LEFT), driveMonitor.getEncoder(DriveMonitor::RIGHT),
 [&]() { return gps.inchToCounts(1); },
 [&]() { return gps.radiansToCounts(1); },
 base, getBaseState()} {
@@ -233,7 +307,11 @@ void Elliot::give() {
 }
 
 void Elliot::beginTasks() {
+    //Telemetry first, so the GPS daemon's first tick has a snapshot to read.
+    beginTelemetryTask({motorPorts::left1, motorPorts::left2, motorPorts::right1, motorPorts::right2,
+                        motorPorts::puncher, motorPorts::angler, motorPorts::intake, motorPorts::scorer}, &gps, &driveMonitor);
     gps.beginTask();
+    beginBatteryTask();
     puncher.beginTask();
     pros::Task shotTask(autoshootTask);
 }
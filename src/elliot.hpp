@@ -11,6 +11,9 @@
 #include "base.hpp"
 #include "debugging.hpp"
 #include "ccpid_mod.hpp"
+#include "driveMonitor.hpp"
+#include "input.hpp"
+#include "controlTrace.hpp"
 #include <deque>
 using namespace okapi;
 
@@ -28,32 +31,42 @@ class Puncher {
     int puncherTarget;
     ///Motor driving puncher
     okapi::MotorGroup &puncher;
+    ///Port of \ref puncher, for reading it from telemetry.
+    int puncherPort;
     ///Motor driving puncher angle-changer.
     okapi::MotorGroup &angler;
+    ///Port of \ref angler, for reading it from telemetry.
+    int anglerPort;
     ///Potentiometer sensor attached to angle-changer.
     okapi::Potentiometer &angleSense;
     ///Puncher JSON settings location
     json& puncherData;
-    ///Angler PID controller
+    ///Angler PID controller. Replaced by loadState(), so read it through controller().
     std::shared_ptr<okapi::AsyncPosPIDController> controllerPtr;
+    ///Guards \ref controllerPtr, so a copy taken by another task keeps its controller alive.
+    pros::Mutex controllerLock;
+    ///Copies \ref controllerPtr under \ref controllerLock.
+    std::shared_ptr<okapi::AsyncPosPIDController> controller();
+    ///Trace of the angler's signals, pushed by puncherTask().
+    TraceRing trace;
     ///Reload puncher settings from SD card, called automatically from all setter functions.
     void loadState();
     ///Background task for puncher, which will stop the integrated PID controller when it is
-    ///motionless and close to the target.
+    ///motionless and close to the target. It also traces the angler while its PID runs.
     void puncherTask();
     public:
-    ///Puncher constructor, taking the puncher motor, the angler motor, the potentiometer,
-    ///and the JSON data save location.
-    Puncher(okapi::MotorGroup& puncher, okapi::MotorGroup& angler, okapi::Potentiometer& angleSense, json& puncherData);
+    ///Puncher constructor, taking the puncher motor & its port, the angler motor & its port,
+    ///the potentiometer, and the JSON data save location.
+    Puncher(okapi::MotorGroup& puncher, int puncherPort, okapi::MotorGroup& angler, int anglerPort, okapi::Potentiometer& angleSense, json& puncherData);
     ///Runs puncherTask() as a pros::Task
     void beginTask() {
         pros::Task([](void* me) {((Puncher*)me)->puncherTask();}, (void*)this);
     }
-    ///Sets the target of \ref controllerPtr to \ref lowTargetPosition.
+    ///Sets the target of the angler's controller to \ref lowTargetPosition.
     void lowTarget();
-    ///Sets the target of \ref controllerPtr to \ref highTargetPosition.
+    ///Sets the target of the angler's controller to \ref highTargetPosition.
     void highTarget();
-    ///Stops \ref controllerPtr.
+    ///Stops the angler's controller.
     void stopAutoControl();
     ///Advances puncher motor's target by 1 revolution.
     void shoot();
@@ -61,6 +74,8 @@ class Puncher {
     void setVelocity(double vel);
     ///Angler's error to its target.
     int targetError();
+    ///Trace of the angler's PID error, velocity & current. One task may pop it, see TraceRing.
+    TraceRing& getTrace() { return trace; }
     ///Toggle angler between high & low target.
     void toggleTarget();
     ///Gets the PID gains used to control the angler.
@@ -77,6 +92,20 @@ class Puncher {
     int getHighTarget() { return highTargetPosition; }
 };
 
+/**
+ * Smart ports of Elliot's motors, for everything that needs to know them:
+ * the motors themselves, the drive monitor, telemetry and the dashboard.
+ * Negative ports run reversed.
+ */
+namespace motorPorts {
+    constexpr int left1 = 12, left2 = 1;
+    constexpr int right1 = -3, right2 = -4;
+    constexpr int puncher = 5;
+    constexpr int angler = 8;
+    constexpr int intake = 10;
+    constexpr int scorer = 6;
+}
+
 enum DriveStyle {
     DADDY_DRIVING  = 0,
     UNGATO_DRIVING = 1337
@@ -113,6 +142,10 @@ class Elliot {
     okapi::Potentiometer angleSense;
     ///Puncher object managing the puncher and its angler.
     Puncher puncher;
+    ///@brief Watches the motors of \ref left and \ref right for faults.
+    ///Its ports must match those of \ref left and \ref right.
+    ///@see DriveMonitor
+    DriveMonitor driveMonitor;
     ///@brief GPS object keeping track of robot position & orientation.
     ///@see GPS
     GPS gps;
@@ -138,8 +171,9 @@ class Elliot {
     static void give();
     ///Gives the \ref usageGuard mutex without stopping the robot.
     static void giveDirect();
-    ///Does one tick of robot driving, with control from \ref controller.
-    void drive(pros::Controller&, pros::Controller&, DriveStyle style);
+    ///Does one tick of robot driving, with buttons & joysticks from an InputQueue on \ref controller,
+    ///and the scorer joystick from a secondary controller.
+    void drive(InputQueue&, pros::Controller&, DriveStyle style);
     ///Begins the background tasks for the GPS \ref gps & the \ref base.
     void beginTasks();
 };
@@ -2,6 +2,7 @@
 #include "gps.hpp"
 #include "okapi/api.hpp"
 #include "state.hpp"
+#include "telemetry.hpp"
 #include "json.hpp"
 #include <deque>
 using namespace okapi;
@@ -13,7 +14,7 @@ double periodicallyEfficient(double n, double p) {
     return n;
 }
 
-GPS::GPS(MotorGroup& leftSide, MotorGroup& rightSide, json& idata): left(leftSide), right(rightSide), data(idata) {
+GPS::GPS(MotorGroup& leftSide, MotorGroup& rightSide, DriveMonitor& imonitor, json& idata): left(leftSide), right(rightSide), monitor(imonitor), data(idata) {
     cpi = data["cpi"].get<double>();
     cpr = data["cpr"].get<double>();
 }
@@ -52,18 +53,23 @@ void GPS::setPosition(RoboPosition pos) {
 }
 
 void GPS::gpsDaemon() {
-    uint32_t lastTime = pros::c::millis();
-    //These two change how encoder smoothing happens.
+    //This changes how encoder smoothing happens.
     const int sampleCount = 1;
-    const int dT = 10;
     pair<double, double> lastMeasurement;
     deque<pair<double, double>> samples; 
     for(int i = 0; i < sampleCount; i++) {
         samples.push_back({0.0f, 0.0f});
     }
+    //The telemetry daemon updates the monitor, then wakes this task, so every tick integrates fresh positions.
+    const bool subscribed = subscribeTelemetry(pros::c::task_get_current());
     while(true) {
+        if(!subscribed) {
+            pros::c::task_delay(getTelemetryPeriod());
+        } else if(!pros::c::task_notify_take(true, maxTelemetryPeriod * 2)) {
+            continue;
+        }
         samples.pop_front();
-        samples.push_back({left.getPosition(), right.getPosition()});
+        samples.push_back({monitor.getPosition(DriveMonitor::LEFT), monitor.getPosition(DriveMonitor::RIGHT)});
         pair<double, double> currentMeasurement;
         for(auto &sample: samples) {
             currentMeasurement.first += sample.first;
@@ -79,28 +85,32 @@ void GPS::gpsDaemon() {
         daemonLock.take(TIMEOUT_MAX);
         addPosDelta(position, delta.first, delta.second);
         daemonLock.give();
-        pros::c::task_delay_until(&lastTime, dT);
     }
 }
 
 void GPS::addPosDelta(RoboPosition& robot, double L, double R) {
+    arcIntegrate(robot, L, R, cpr);
+}
+
+void arcIntegrate(RoboPosition& robot, double L, double R, double cpr) {
     //No motion
     if(R == 0 && L == 0) {
         return;
     }
 
     //Change in angle
-    double dTheta = countsToRadians(R-L) / 2;
+    double dTheta = (R-L) / (2 * cpr);
 
     //Straight/reverse (Infinite circle)
+    //The arc radius blows up here, so fall back to the midpoint approximation,
+    //which is exact to second order in dTheta.
     if(abs(dTheta) < 0.0001) {
-        robot.x += cos(robot.o) * L;
-        robot.y += sin(robot.o) * R;
+        midpointIntegrate(robot, L, R, cpr);
         return;
     }
 
     //Turning circle radius
-    double r = radiansToCounts((R + L) / (R - L));
+    double r = cpr * ((R + L) / (R - L));
 	
     //Rotation around turning circle by dTheta
     //The math here is quite compact, but there's a simple way to think about it.
@@ -112,3 +122,14 @@ void GPS::addPosDelta(RoboPosition& robot, double L, double R) {
     robot.y += (cos(robot.o) - cos(robot.o + dTheta)) * r;
     robot.o += dTheta;
 }
+
+void midpointIntegrate(RoboPosition& robot, double L, double R, double cpr) {
+    //Distance travelled by the center of the robot
+    double d = (L + R) / 2;
+    //Change in angle
+    double dTheta = (R-L) / (2 * cpr);
+    //Move along the heading halfway through the turn
+    robot.x += cos(robot.o + dTheta / 2) * d;
+    robot.y += sin(robot.o + dTheta / 2) * d;
+    robot.o += dTheta;
+}
@@ -2,6 +2,7 @@
 #include "main.h"
 #include "okapi/api.hpp"
 #include "json.hpp"
+#include "driveMonitor.hpp"
 using json = nlohmann::json;
 using namespace okapi;
 
@@ -22,7 +23,9 @@ class GPS {
     public:
     MotorGroup& left;
     MotorGroup& right;
-    GPS(MotorGroup& leftSide, MotorGroup& rightSide, json& idata);
+    //Source of per-side positions, ignoring faulted motors
+    DriveMonitor& monitor;
+    GPS(MotorGroup& leftSide, MotorGroup& rightSide, DriveMonitor& imonitor, json& idata);
 
     void setCPR(double newCPR);
 
@@ -46,3 +49,23 @@ class GPS {
 };
 
 double periodicallyEfficient(double n, double p = PI * 2);
+
+/**
+ * Integrates a pair of encoder deltas into a position, treating the motion
+ * as an exact circular arc. This is the integrator GPS::addPosDelta() uses.
+ * 
+ * @param robot Position to update, in encoder counts & radians
+ * @param L     Left side encoder delta
+ * @param R     Right side encoder delta
+ * @param cpr   Encoder counts per radian of robot rotation
+ */
+void arcIntegrate(RoboPosition& robot, double L, double R, double cpr);
+
+/**
+ * Integrates a pair of encoder deltas into a position with a second-order
+ * (midpoint heading) approximation of the arc. Kept for comparison in the
+ * odometry benchmark.
+ * 
+ * @see arcIntegrate()
+ */
+void midpointIntegrate(RoboPosition& robot, double L, double R, double cpr);
@@ -0,0 +1,196 @@
+/**
+ * @file input.cpp
+ *
+ * This file defines the controller input service, which samples both
+ * controllers in one task and hands out button events through queues.
+ */
+
+#include "main.h"
+#include "input.hpp"
+#include <algorithm>
+#include <atomic>
+
+///Time a button must be held before it starts repeating, in ms.
+const uint32_t repeatDelay = 400;
+///Time between the first repeats, in ms.
+const uint32_t repeatInterval = 150;
+///Shortest time between repeats, in ms, reached after holding for a while.
+const uint32_t fastestRepeatInterval = 40;
+///Each repeat comes this much sooner than the last, until fastestRepeatInterval.
+const double repeatAcceleration = 0.85;
+///Most queues that may subscribe at once.
+const int maxSubscribers = 8;
+
+const int buttonCount = pros::E_CONTROLLER_DIGITAL_A - pros::E_CONTROLLER_DIGITAL_L1 + 1;
+const int axisCount = 4;
+
+///Subscribed queues. Guarded by inputLock, as are the queues' contents.
+static InputQueue* subscribers[maxSubscribers];
+static pros::Mutex inputLock;
+///Button & joystick state from the last sample, by controller. Only the input task writes these.
+static std::atomic_bool buttonsHeld[2][buttonCount];
+static std::atomic_int axes[2][axisCount];
+
+void InputQueue::inputTask(void*) {
+  //Hold-to-repeat state of each button.
+  struct Repeat { uint32_t next; uint32_t interval; } repeats[2][buttonCount] = {};
+  uint32_t lastTime = pros::millis();
+  while(true) {
+    const uint32_t now = pros::millis();
+    for(int id: {pros::E_CONTROLLER_MASTER, pros::E_CONTROLLER_PARTNER}) {
+      const auto controller = (pros::controller_id_e_t)id;
+      const bool connected = pros::c::controller_is_connected(controller) == 1;
+      for(int axis = 0; axis < axisCount; axis++) {
+        axes[id][axis].store(connected ? pros::c::controller_get_analog(controller, (pros::controller_analog_e_t)axis) : 0);
+      }
+      for(int i = 0; i < buttonCount; i++) {
+        const auto button = (pros::controller_digital_e_t)(pros::E_CONTROLLER_DIGITAL_L1 + i);
+        const bool down = connected && pros::c::controller_get_digital(controller, button) == 1;
+        const bool wasDown = buttonsHeld[id][i].exchange(down);
+        auto &repeat = repeats[id][i];
+        InputKind kind;
+        if(down && !wasDown) {
+          kind = InputKind::PRESS;
+          repeat = {now + repeatDelay, repeatInterval};
+        } else if(!down && wasDown) {
+          kind = InputKind::RELEASE;
+        } else if(down && (int32_t)(now - repeat.next) >= 0) {
+          kind = InputKind::REPEAT;
+          repeat.next = now + repeat.interval;
+          repeat.interval = std::max<uint32_t>(repeat.interval * repeatAcceleration, fastestRepeatInterval);
+        } else {
+          continue;
+        }
+        const InputEvent event = {now, controller, button, kind};
+        inputLock.take(TIMEOUT_MAX);
+        for(auto *queue: subscribers) {
+          if(!queue || queue->controller != controller) continue;
+          //A full queue overwrites its oldest event.
+          queue->events[(queue->head + queue->count) % inputQueueSize] = event;
+          if(queue->count < inputQueueSize) {
+            queue->count++;
+          } else {
+            queue->head = (queue->head + 1) % inputQueueSize;
+          }
+          queue->fresh = true;
+          if(queue->waiter) pros::c::task_notify(queue->waiter);
+        }
+        inputLock.give();
+      }
+    }
+    pros::c::task_delay_until(&lastTime, inputPeriod);
+  }
+}
+
+InputQueue::InputQueue(pros::controller_id_e_t icontroller): controller(icontroller) {
+  static bool started = false;
+  inputLock.take(TIMEOUT_MAX);
+  if(!started) {
+    pros::Task task(inputTask, nullptr, TASK_PRIORITY_DEFAULT + 1, TASK_STACK_DEPTH_DEFAULT, "Input");
+    started = true;
+  }
+  auto slot = std::find(subscribers, subscribers + maxSubscribers, nullptr);
+  if(slot != subscribers + maxSubscribers) {
+    *slot = this;
+  } else {
+    printf("InputQueue: too many subscribers, this one won't get events\n");
+  }
+  inputLock.give();
+}
+
+InputQueue::~InputQueue() {
+  inputLock.take(TIMEOUT_MAX);
+  std::replace(subscribers, subscribers + maxSubscribers, this, (InputQueue*)nullptr);
+  inputLock.give();
+}
+
+void InputQueue::dropStale() {
+  const uint32_t now = pros::millis();
+  while(count && now - events[head].time > staleEventAge) {
+    head = (head + 1) % inputQueueSize;
+    count--;
+  }
+}
+
+bool InputQueue::poll(InputEvent& out) {
+  inputLock.take(TIMEOUT_MAX);
+  dropStale();
+  const bool found = count > 0;
+  if(found) {
+    out = events[head];
+    head = (head + 1) % inputQueueSize;
+    count--;
+  }
+  inputLock.give();
+  return found;
+}
+
+bool InputQueue::take(pros::controller_digital_e_t button, bool repeats) {
+  inputLock.take(TIMEOUT_MAX);
+  dropStale();
+  bool found = false;
+  for(int i = 0; i < count && !found; i++) {
+    auto &event = events[(head + i) % inputQueueSize];
+    if(event.button != button) continue;
+    if(event.kind == InputKind::PRESS || (repeats && event.kind == InputKind::REPEAT)) {
+      //Close the gap, keeping the rest of the queue in order.
+      for(int j = i; j < count - 1; j++) {
+        events[(head + j) % inputQueueSize] = events[(head + j + 1) % inputQueueSize];
+      }
+      count--;
+      found = true;
+    }
+  }
+  inputLock.give();
+  return found;
+}
+
+bool InputQueue::newPress(pros::controller_digital_e_t button) {
+  return take(button, false);
+}
+
+bool InputQueue::newPressOrRepeat(pros::controller_digital_e_t button) {
+  return take(button, true);
+}
+
+bool InputQueue::held(pros::controller_digital_e_t button) const {
+  return buttonsHeld[controller][button - pros::E_CONTROLLER_DIGITAL_L1].load();
+}
+
+int InputQueue::analog(pros::controller_analog_e_t axis) const {
+  return axes[controller][axis].load();
+}
+
+void InputQueue::clear() {
+  inputLock.take(TIMEOUT_MAX);
+  head = count = 0;
+  inputLock.give();
+}
+
+bool InputQueue::wait(uint32_t timeout) {
+  inputLock.take(TIMEOUT_MAX);
+  //An event that came in since the last check would otherwise go unnoticed until the timeout.
+  if(fresh) {
+    fresh = false;
+    inputLock.give();
+    return true;
+  }
+  waiter = pros::c::task_get_current();
+  inputLock.give();
+  const bool notified = pros::c::task_notify_take(true, timeout) > 0;
+  inputLock.take(TIMEOUT_MAX);
+  waiter = nullptr;
+  fresh = false;
+  inputLock.give();
+  return notified;
+}
+
+InputQueue& menuInput() {
+  static InputQueue queue;
+  return queue;
+}
+
+InputQueue& driverInput() {
+  static InputQueue queue;
+  return queue;
+}
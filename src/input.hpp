@@ -0,0 +1,141 @@
+/**
+ * @file input.hpp
+ *
+ * This file declares the controller input service, which samples both
+ * controllers in one task and hands out button events through queues.
+ */
+
+#pragma once
+#include "main.h"
+#include <cstdint>
+
+///Time between controller samples, in ms.
+const uint32_t inputPeriod = 10;
+///Events older than this, in ms, are dropped rather than handed out.
+const uint32_t staleEventAge = 250;
+///Events a queue holds before the oldest are overwritten.
+const int inputQueueSize = 32;
+///Longest a menu waits for input, in ms, before checking joysticks & timers again.
+const uint32_t menuWaitTimeout = 50;
+
+///What happened to a button.
+enum class InputKind {
+  PRESS,   ///< Button went down
+  RELEASE, ///< Button came up
+  REPEAT   ///< Button is being held, and repeats faster the longer it's held
+};
+
+///One button event.
+struct InputEvent {
+  ///Time the button was sampled, in ms.
+  uint32_t time;
+  pros::controller_id_e_t controller;
+  pros::controller_digital_e_t button;
+  InputKind kind;
+};
+
+/**
+ * A subscriber's queue of button events from one controller. Every queue
+ * gets every event, so one consumer taking a press no longer steals it from
+ * another. Events older than staleEventAge are dropped as they're read, so
+ * a consumer that was blocked (say, while a menu had the robot) doesn't act
+ * on presses that weren't meant for it.
+ *
+ * Queues subscribe on construction and unsubscribe on destruction. The
+ * input task is started by the first queue. PROS deletes competition tasks
+ * without unwinding their stacks, so opcontrol() & friends must use a
+ * long-lived queue like driverInput(), never one of their own.
+ */
+class InputQueue {
+  public:
+  /**
+   * Subscribes to events from a controller.
+   *
+   * @param icontroller Controller to take events from
+   */
+  InputQueue(pros::controller_id_e_t icontroller = pros::E_CONTROLLER_MASTER);
+  ~InputQueue();
+  InputQueue(const InputQueue&) = delete;
+  InputQueue& operator=(const InputQueue&) = delete;
+
+  /**
+   * Takes the oldest event in the queue.
+   *
+   * @param out Where to write the event
+   * @return Whether there was an event
+   */
+  bool poll(InputEvent& out);
+
+  /**
+   * Takes the oldest press of a button from the queue, leaving events for
+   * other buttons in place. This replaces get_digital_new_press().
+   *
+   * @param button Button to look for
+   * @return Whether the button was pressed
+   */
+  bool newPress(pros::controller_digital_e_t button);
+
+  /**
+   * Like newPress(), but hold-to-repeat events count too. Used for scrolling.
+   *
+   * @param button Button to look for
+   */
+  bool newPressOrRepeat(pros::controller_digital_e_t button);
+
+  ///Whether a button is down, as of the last sample.
+  bool held(pros::controller_digital_e_t button) const;
+
+  ///Gets a joystick axis in [-127, 127], as of the last sample.
+  int analog(pros::controller_analog_e_t axis) const;
+
+  ///Drops every queued event.
+  void clear();
+
+  /**
+   * Blocks until an event arrives that hasn't been waited for yet, or until
+   * the timeout. Menus call this between checks in place of a fixed delay,
+   * so a press is handled as soon as it's sampled but an idle menu sleeps.
+   * Joysticks don't make events, so loops that scroll with them should
+   * keep the timeout short.
+   *
+   * @param timeout Longest time to wait, in ms
+   * @return Whether an event arrived
+   */
+  bool wait(uint32_t timeout);
+
+  private:
+  /**
+   * Takes the oldest event for a button matching a kind.
+   *
+   * @param repeats Whether REPEAT events match as well as PRESS events
+   */
+  bool take(pros::controller_digital_e_t button, bool repeats);
+  ///Drops events older than staleEventAge. Called with the input lock held.
+  void dropStale();
+
+  pros::controller_id_e_t controller;
+  ///Ring buffer of events, oldest at \ref head.
+  InputEvent events[inputQueueSize];
+  int head = 0;
+  int count = 0;
+  ///Whether an event arrived since the last wait().
+  bool fresh = false;
+  ///Task blocked in wait(), to be notified of the next event, or nullptr.
+  pros::task_t waiter = nullptr;
+
+  ///Samples both controllers every inputPeriod, sending events to every queue.
+  static void inputTask(void*);
+};
+
+/**
+ * Gets the queue shared by catOS menus, editors and anything run from
+ * them. They run one at a time on catOS's task, so they share one queue and
+ * a press is only handled once.
+ */
+InputQueue& menuInput();
+
+/**
+ * Gets the queue opcontrol() drives from. It outlives every opcontrol()
+ * task, which PROS deletes whenever the competition mode changes.
+ */
+InputQueue& driverInput();
@@ -0,0 +1,98 @@
+/**
+ * @file jobs.cpp
+ *
+ * This file defines the job runner, which runs long catOS actions (autons,
+ * tuning runs, benchmarks) in the background so they can be cancelled.
+ */
+
+#include "main.h"
+#include "jobs.hpp"
+#include "catOS.hpp"
+#include "elliot.hpp"
+#include "input.hpp"
+#include <algorithm>
+#include <atomic>
+
+///Time between checks of a running job, in ms.
+const uint32_t jobPollPeriod = 20;
+
+///State shared by a job's task & the task that started it.
+struct Job {
+  std::function<void()> work;
+  std::atomic_bool cancelled{false};
+  std::atomic_bool done{false};
+};
+
+///The running job, or nullptr. Only set & cleared by runJob().
+static std::atomic<Job*> currentJob{nullptr};
+///Progress text of the running job. Guarded by progressLock.
+static std::string progressText;
+static pros::Mutex progressLock;
+
+static void jobTask(void* param) {
+  auto *job = (Job*)param;
+  try {
+    job->work();
+  } catch(...) {
+    printf("Job threw an exception, stopping it\n");
+  }
+  job->done.store(true);
+}
+
+bool runJob(const std::string& name, std::function<void()> work) {
+  if(currentJob.load()) {
+    printf("runJob: %s asked to run inside another job, running it in place\n", name.c_str());
+    work();
+    return !jobCancelled();
+  }
+  //Owned here, and only deleted once the task is done with it.
+  auto *job = new Job;
+  job->work = std::move(work);
+  jobProgress("");
+  currentJob.store(job);
+  pros::Task task(jobTask, job, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "Job");
+
+  auto &ctrl = menuInput();
+  ctrl.clear();
+  line_set(0, name);
+  line_set(2, "B to cancel");
+  while(!job->done.load()) {
+    if(!job->cancelled.load() && ctrl.newPress(DIGITAL_B)) {
+      job->cancelled.store(true);
+      line_set(2, "Cancelling...");
+    }
+    if(job->cancelled.load()) {
+      //Keep stopping the base, in case the job started a movement before it checked.
+      getRobot().base->stop();
+    }
+    progressLock.take(TIMEOUT_MAX);
+    std::string progress = progressText;
+    progressLock.give();
+    line_set(1, progress);
+    ctrl.wait(jobPollPeriod);
+  }
+  const bool finished = !job->cancelled.load();
+  currentJob.store(nullptr);
+  delete job;
+  getRobot().stop();
+  ctrl.clear();
+  return finished;
+}
+
+bool jobCancelled() {
+  auto *job = currentJob.load();
+  return job && job->cancelled.load();
+}
+
+void jobProgress(const std::string& text) {
+  progressLock.take(TIMEOUT_MAX);
+  progressText = text;
+  progressLock.give();
+}
+
+void jobDelay(uint32_t ms) {
+  const uint32_t end = pros::millis() + ms;
+  while(!jobCancelled() && (int32_t)(end - pros::millis()) > 0) {
+    pros::delay(std::min<uint32_t>(end - pros::millis(), jobPollPeriod));
+  }
+}
@@ -0,0 +1,45 @@
+/**
+ * @file jobs.hpp
+ *
+ * This file declares the job runner, which runs long catOS actions (autons,
+ * tuning runs, benchmarks) in the background so they can be cancelled.
+ */
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Runs work on its own task while the calling (menu) task shows its
+ * progress on the controller. Pressing B cancels the job: the token read by
+ * jobCancelled() is set and the base is stopped, which ends any movement
+ * it's waiting on. Jobs are never killed, so they can't die holding a mutex
+ * or leave a motor running; runJob() waits for the work to notice and
+ * return, then stops the robot whether it finished or not.
+ *
+ * Only one job runs at a time. Outside a job, jobCancelled() is always
+ * false, so the same code runs unchanged in competition autonomous.
+ *
+ * @param name Name shown on the controller while running
+ * @param work What to do. Should check jobCancelled() wherever it loops or waits.
+ * @return Whether the work finished without being cancelled
+ */
+bool runJob(const std::string& name, std::function<void()> work);
+
+///Whether the running job has been cancelled. False outside a job.
+bool jobCancelled();
+
+/**
+ * Sets the progress text of the running job, shown on the controller's
+ * middle line. Does nothing outside a job.
+ */
+void jobProgress(const std::string& text);
+
+/**
+ * Waits like pros::delay(), but returns early if the running job is
+ * cancelled.
+ *
+ * @param ms Time to wait, in ms
+ */
+void jobDelay(uint32_t ms);
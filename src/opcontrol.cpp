@@ -22,16 +22,16 @@ double cube(double n) {
 	return n * n * n;
 }
 
-void Elliot::drive(pros::Controller& m, pros::Controller& secondary, DriveStyle style) {
+void Elliot::drive(InputQueue& m, pros::Controller& secondary, DriveStyle style) {
 	//Base drive
 	double y = 0;
 	double x = 0;
 	if(style == DADDY_DRIVING) {
-		y = dz(m.get_analog(ANALOG_LEFT_Y) * (1 / 127.0), 0.16);
-		x = dz(m.get_analog(ANALOG_LEFT_X) * (1 / 127.0), 0.16);
+		y = dz(m.analog(ANALOG_LEFT_Y) * (1 / 127.0), 0.16);
+		x = dz(m.analog(ANALOG_LEFT_X) * (1 / 127.0), 0.16);
 	} else if(style == UNGATO_DRIVING) {
-		y = cube(dz(m.get_analog(ANALOG_LEFT_Y), 32) * (1 / 127.0));
-		x = cube(dz(m.get_analog(ANALOG_LEFT_X), 32) * (1 / 127.0));
+		y = cube(dz(m.analog(ANALOG_LEFT_Y), 32) * (1 / 127.0));
+		x = cube(dz(m.analog(ANALOG_LEFT_X), 32) * (1 / 127.0));
 	}
 
 	if(y != 0 || x != 0) {
@@ -43,7 +43,7 @@ void Elliot::drive(pros::Controller& m, pros::Controller& secondary, DriveStyle
 	}
 
 	//Scorer drive
-	double scorerVel = (!!m.get_digital(DIGITAL_L2) - !!m.get_digital(DIGITAL_R2));
+	double scorerVel = (!!m.held(DIGITAL_L2) - !!m.held(DIGITAL_R2));
 	if(!scorerVel) {
 		scorerVel = secondary.get_analog(ANALOG_RIGHT_Y) / 127.0;
 	}
@@ -51,27 +51,27 @@ void Elliot::drive(pros::Controller& m, pros::Controller& secondary, DriveStyle
 
 	if(!autoshootActive) {
 		//Puncher drive
-		if(m.get_digital_new_press(DIGITAL_R1)) {
+		if(m.newPress(DIGITAL_R1)) {
 			puncher.shoot();
 		}
 		
 		//Angler drive
-		if(m.get_digital_new_press(DIGITAL_L1)) {
+		if(m.newPress(DIGITAL_L1)) {
 			puncher.toggleTarget();
 		}
 	}
 
 	//Intake drive
-	int intakeVel = -m.get_analog(ANALOG_RIGHT_Y) * (600.0 / 127.0);
+	int intakeVel = -m.analog(ANALOG_RIGHT_Y) * (600.0 / 127.0);
 	intake.moveVelocity(intakeVel);
 
 	//Reverse button
-	if(m.get_digital_new_press(DIGITAL_B)) {
+	if(m.newPress(DIGITAL_B)) {
 		multiplier *= -1;
 	}
 
 	//Brake button
-	if(m.get_digital_new_press(DIGITAL_X)) {
+	if(m.newPress(DIGITAL_X)) {
 		auto old = left.getBrakeMode();
 		if(old == AbstractMotor::brakeMode::hold) {
 			base->setBrakeMode(AbstractMotor::brakeMode::coast);
@@ -83,19 +83,24 @@ void Elliot::drive(pros::Controller& m, pros::Controller& secondary, DriveStyle
 	//30sec warning
 	if(opctrlBegin != -1L && opctrlBegin < pros::millis() - 75000)  {
 		opctrlBegin = -1L;
-		m.rumble(".. ..");
+		controller.rumble(".. ..");
 	}
 }
 
 void opcontrol() {
-	pros::Controller m(pros::E_CONTROLLER_MASTER);
+	auto &m = driverInput();
+	//Presses made before this driver period were meant for the last one.
+	m.clear();
 	auto &bot = getRobot();
   Elliot::give();
 	bot.opctrlBegin = pros::millis();
 	while (true) {
 		//takeCoast and giveDirect allow for controller
 		//menus to safely take over the robot.
+		uint32_t waitStart = pros::millis();
 		Elliot::takeCoast();
+		//Presses made while a menu had the robot were meant for the menu.
+		if(pros::millis() - waitStart > inputPeriod) m.clear();
 		bot.drive(m, bot.partner, bot.driveStyle);
 		Elliot::giveDirect();
 		pros::delay(5);
@@ -9,7 +9,8 @@ using namespace std;
 
 string filePath = "";
 string oldName = "";
-bool latestFileNameWrittenOK = false;
+//Whether filePath's snapshot & journal are written, and /usd/latest.txt names them.
+bool journalStarted = false;
 
 string get_file_contents(const string &filename) {
   FILE *fp = fopen(filename.c_str(), "rb");
@@ -23,8 +24,8 @@ string get_file_contents(const string &filename) {
   return contents;
 }
 
-void write_file_contents(const string &filename, const string &data) {
-  FILE *fp = fopen(filename.c_str(), "wb");
+void write_file_contents(const string &filename, const string &data, const char* mode = "wb") {
+  FILE *fp = fopen(filename.c_str(), mode);
   if(!fp) throw errno;
   fwrite(data.data(), data.size(), 1, fp);
   fclose(fp);
@@ -102,41 +103,226 @@ void gen_file_name() {
     try {
         //First, check for data in latest.txt for an old filename.
         oldName = get_file_contents("/usd/latest.txt");
-        auto oldFile = get_file_contents(oldName);
-        //Then, make a new name.
-        auto newName = "/usd/" + gen_random(8);
-        //Write it to latest.txt.
-        write_file_contents("/usd/latest.txt", newName);
-        latestFileNameWrittenOK = true;
-        //Copy old file contents to new file
-        write_file_contents(newName, oldFile);
-        //Return new name.
-        filePath = newName;
     } catch(...) {
-        //Otherwise, just generate a random name.
-        auto newName = "/usd/" + gen_random(8);
-        //Return new name.
-        filePath = newName;
+        oldName = "";
     }
+    //Then, make a new name. latest.txt only moves to it once startJournal()
+    //has written its snapshot & journal, so the old ones stay loadable until then.
+    filePath = "/usd/" + gen_random(8);
 }
 
 json& getState();
 
 uint32_t lastSaveTime;
 
-void saveState() {
+//Guarded by listenerLock, as the writer may already be running when a listener is added.
+vector<function<void(const json&)>> saveListeners;
+pros::Mutex listenerLock;
+
+void onStateSaved(function<void(const json&)> listener) {
+    listenerLock.take(TIMEOUT_MAX);
+    saveListeners.push_back(listener);
+    listenerLock.give();
+}
+
+SaveStats saveStats;
+
+const SaveStats& getSaveStats() {
+    return saveStats;
+}
+
+void resetSaveStats() {
+    saveStats.requested.store(0);
+    saveStats.written.store(0);
+    saveStats.maxLatency.store(0);
+    for(int i = 0; i < saveLatencyBuckets; i++) {
+        saveStats.journalWrites[i].store(0);
+        saveStats.snapshotWrites[i].store(0);
+    }
+}
+
+//Counts a write that started at start into a histogram.
+void recordWrite(std::atomic<uint32_t> (&histogram)[saveLatencyBuckets], uint32_t start) {
+    const uint32_t latency = pros::millis() - start;
+    int bucket = 0;
+    while(bucket < saveLatencyBuckets - 1 && latency >= saveLatencyBounds[bucket]) bucket++;
+    histogram[bucket].fetch_add(1);
+    //The writer & compaction tasks both record writes.
+    uint32_t max = saveStats.maxLatency.load();
+    while(latency > max && !saveStats.maxLatency.compare_exchange_weak(max, latency));
+}
+
+//-----------------------------------------------------------------------------
+//  Journal
+//  -------
+//  The state lives in a snapshot at filePath, plus a journal at filePath.jnl
+//  of the JSON patches saved since. Each line of the journal is one record:
+//    - {"generation": g} starts the journal, whose patches apply to the
+//      snapshot saved with "journal": g.
+//    - [patch...] is a JSON patch, from one saveState().
+//    - {"snapshot": g} marks where snapshot g was taken, while compacting.
+//  Compacting writes a new snapshot & journal under a new name in the
+//  background, then points /usd/latest.txt at them. Until then the old
+//  snapshot & journal are untouched, apart from records & the marker being
+//  appended, so cutting compaction short loses nothing. Each boot continues
+//  from the loaded snapshot's generation, so generations are never reused.
+//-----------------------------------------------------------------------------
+
+//Generation of the snapshot being journaled against.
+uint32_t generation = 0;
+//The state as of the last record, which the next patch is diffed against.
+json journaled;
+//Sizes of the snapshot & journal on the SD card, in bytes.
+size_t snapshotBytes = 0, journalBytes = 0;
+//Smallest journal worth compacting, in bytes.
+const size_t minCompactBytes = 4096;
+//Whether a snapshot is being written. Records saved meanwhile go in sinceSnapshot.
+bool compacting = false;
+string sinceSnapshot;
+//Guards everything above. Held while appending, but not while writing a snapshot.
+pros::Mutex journalLock;
+
+string journalPath() {
+    return filePath + ".jnl";
+}
+
+/**
+ * Applies a journal's records to the snapshot they follow. A torn last
+ * record, from losing power mid-write, ends the journal.
+ * 
+ * @param state    The snapshot, with its "journal" generation removed
+ * @param snapshot Generation of the snapshot
+ * @param path     Path of the journal
+ * @return Number of patches applied
+ */
+int replayJournal(json& state, uint32_t snapshot, const string& path) {
+    string contents;
+    try {
+        contents = get_file_contents(path);
+    } catch(...) {
+        return 0;
+    }
+    size_t begin = 0;
+    int applied = 0;
+    //Whether the records read so far are already in the snapshot.
+    bool inSnapshot = true;
+    bool first = true;
+    while(begin < contents.size()) {
+        size_t end = contents.find('\n', begin);
+        if(end == string::npos) break;
+        json record = json::parse(contents.begin() + begin, contents.begin() + end, nullptr, false);
+        begin = end + 1;
+        if(record.is_discarded()) break;
+        if(first) {
+            first = false;
+            if(!record.is_object() || !record.count("generation")) break;
+            const uint32_t journal = record["generation"].get<uint32_t>();
+            //An older journal was cut short by compacting, and continues at the snapshot's marker.
+            if(journal == snapshot) inSnapshot = false;
+            else if(journal > snapshot) break;
+        } else if(record.is_object()) {
+            if(record.value("snapshot", 0u) == snapshot) inSnapshot = false;
+        } else if(!inSnapshot) {
+            try {
+                state = state.patch(record);
+                applied++;
+            } catch(...) {
+                printf("Journal record %d of %s doesn't apply, stopping there\n", applied + 1, path.c_str());
+                break;
+            }
+        }
+    }
+    return applied;
+}
+
+//Writes the snapshot taken by compact() to a new file, starts its journal,
+//and only then switches /usd/latest.txt & filePath over to it.
+void compactTask(void* param) {
+    auto *snapshot = (string*)param;
+    const string newPath = "/usd/" + gen_random(8);
     try {
-        auto &state = getState();
-        //Record time-of-save
-        state["lifetime"] = pros::millis() + lastSaveTime;
-        //Get JSON string
-        auto data = state.dump();
-        //filePath will is guaranteed to be set after getState() runs.
-        write_file_contents(filePath, data);
-        //if not latestFileNameWrittenOK, make an attempt to write it.
-        if(!latestFileNameWrittenOK) {
-            write_file_contents("/usd/latest.txt", filePath);
-            latestFileNameWrittenOK = true;
+        const uint32_t start = pros::millis();
+        write_file_contents(newPath, *snapshot);
+        recordWrite(saveStats.snapshotWrites, start);
+        journalLock.take(TIMEOUT_MAX);
+        try {
+            //Records saved while the snapshot was written continue its journal.
+            const string journal = json({{"generation", generation}}).dump() + "\n" + sinceSnapshot;
+            write_file_contents(newPath + ".jnl", journal);
+            write_file_contents("/usd/latest.txt", newPath);
+            filePath = newPath;
+            snapshotBytes = snapshot->size();
+            journalBytes = journal.size();
+        } catch(...) {
+            //latest.txt still names the old snapshot, and its journal still has every record.
+        }
+        sinceSnapshot.clear();
+        compacting = false;
+        journalLock.give();
+    } catch(...) {
+        //The old snapshot was never touched, and its journal still holds everything, so try again next time.
+        journalLock.take(TIMEOUT_MAX);
+        sinceSnapshot.clear();
+        compacting = false;
+        journalLock.give();
+    }
+    delete snapshot;
+}
+
+//Starts writing a snapshot of journaled in the background. journalLock must be held.
+void compact() {
+    generation++;
+    //Marks where the new snapshot was taken, in case the journal isn't restarted.
+    const string marker = json({{"snapshot", generation}}).dump() + "\n";
+    write_file_contents(journalPath(), marker, "ab");
+    journalBytes += marker.size();
+    json snapshot = journaled;
+    snapshot["journal"] = generation;
+    compacting = true;
+    pros::Task(compactTask, new string(snapshot.dump()), TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "Compact");
+}
+
+//Writes a full snapshot of the state, starts a new journal after it, and
+//only then points /usd/latest.txt at them.
+void startJournal(const json& state) {
+    json snapshot = state;
+    snapshot["journal"] = generation;
+    const string data = snapshot.dump();
+    write_file_contents(filePath, data);
+    const string journal = json({{"generation", generation}}).dump() + "\n";
+    write_file_contents(journalPath(), journal);
+    write_file_contents("/usd/latest.txt", filePath);
+    journaled = state;
+    snapshotBytes = data.size();
+    journalBytes = journal.size();
+    journalStarted = true;
+}
+
+//Appends what changed in state since the last record to the journal.
+void writeJournal(const json& state) {
+    journalLock.take(TIMEOUT_MAX);
+    try {
+        const uint32_t start = pros::millis();
+        if(!journalStarted) {
+            //Boot couldn't write a snapshot (no SD card yet?), so a patch would have nothing to apply to.
+            startJournal(state);
+            recordWrite(saveStats.snapshotWrites, start);
+            saveStats.written.fetch_add(1);
+        } else {
+            //Only what changed since the last save is written.
+            const string record = json::diff(journaled, state).dump() + "\n";
+            //filePath will is guaranteed to be set after getState() runs.
+            write_file_contents(journalPath(), record, "ab");
+            recordWrite(saveStats.journalWrites, start);
+            saveStats.written.fetch_add(1);
+            journaled = state;
+            journalBytes += record.size();
+            if(compacting) {
+                sinceSnapshot += record;
+            } else if(journalBytes > std::max(snapshotBytes, minCompactBytes)) {
+                //Replaying the journal now costs more than rewriting the snapshot.
+                compact();
+            }
         }
     } catch(...) {
         printf("Failed to write data. Please check write protection / SD inserted.\n");
@@ -146,8 +332,74 @@ void saveState() {
         m.set_text(0, 0, "SD CARD FAILURE");
         m.set_text(1, 0, "CHECK TERMINAL ");
         m.set_text(2, 0, "FOR DATA       ");
-        printf("%s", getState().dump().c_str());
+        printf("%s", state.dump().c_str());
+    }
+    journalLock.give();
+}
+
+//-----------------------------------------------------------------------------
+//  Save Writer
+//  -----------
+//  saveState() copies the state for a low-priority writer task, and returns
+//  without touching the SD card. The writer waits for a burst of saves to go
+//  quiet before writing, so a burst costs one journal record.
+//-----------------------------------------------------------------------------
+
+//Time without a save before the writer writes, in ms.
+const uint32_t saveDebounce = 100;
+//Longest the writer lets a steady stream of saves go unwritten, in ms.
+const uint32_t saveMaxDelay = 1000;
+//Latest copy of the state waiting to be written, or nullptr. Guarded by pendingLock.
+unique_ptr<json> pending;
+//Times of the first & latest saves since pending was last written. Guarded by pendingLock.
+uint32_t firstRequest = 0, lastRequest = 0;
+pros::Mutex pendingLock;
+pros::task_t writerTask = nullptr;
+
+void saveWriter(void*) {
+    while(true) {
+        pros::c::task_notify_take(true, TIMEOUT_MAX);
+        //Let the burst of saves finish, or give up waiting for it to.
+        while(true) {
+            pendingLock.take(TIMEOUT_MAX);
+            const uint32_t now = pros::millis();
+            const uint32_t quiet = now - lastRequest, waited = now - firstRequest;
+            pendingLock.give();
+            if(quiet >= saveDebounce || waited >= saveMaxDelay) break;
+            pros::delay(std::min(saveDebounce - quiet, saveMaxDelay - waited));
+        }
+        unique_ptr<json> state;
+        pendingLock.take(TIMEOUT_MAX);
+        swap(state, pending);
+        pendingLock.give();
+        if(!state) continue;
+        writeJournal(*state);
+        //Listeners run here, so a save never waits on them, and they get a copy no one is editing.
+        listenerLock.take(TIMEOUT_MAX);
+        auto listeners = saveListeners;
+        listenerLock.give();
+        for(auto &listener: listeners) {
+            listener(*state);
+        }
+    }
+}
+
+void saveState() {
+    auto &state = getState();
+    //Record time-of-save
+    state["lifetime"] = pros::millis() + lastSaveTime;
+    //Copied on the task that changed it, so the writer never sees it mid-edit.
+    auto copy = make_unique<json>(state);
+    pendingLock.take(TIMEOUT_MAX);
+    if(!pending) firstRequest = pros::millis();
+    lastRequest = pros::millis();
+    swap(copy, pending);
+    if(!writerTask) {
+        writerTask = pros::c::task_create(saveWriter, nullptr, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "Save Writer");
     }
+    pendingLock.give();
+    saveStats.requested.fetch_add(1);
+    pros::c::task_notify(writerTask);
 }
 
 json* curState;
@@ -158,7 +410,13 @@ json& getState() {
         try {
             gen_file_name();
             printf("Will save to %s\n", filePath.c_str());
-            *curState = json::parse(get_file_contents(filePath));
+            *curState = json::parse(get_file_contents(oldName));
+            const uint32_t snapshot = curState->value("journal", 0u);
+            curState->erase("journal");
+            const int applied = replayJournal(*curState, snapshot, oldName + ".jnl");
+            printf("Replayed %d saves from the journal\n", applied);
+            //The snapshot startJournal() writes is a new generation of this one.
+            generation = snapshot + 1;
         } catch(...) {
             printf("No SD card data found.\n");
         }
@@ -169,6 +427,12 @@ json& getState() {
             (*curState)["prevName"] = oldName;
         }
         lastSaveTime = (*curState)["lifetime"].get<double>();
+        try {
+            startJournal(*curState);
+        } catch(...) {
+            //saveState() will report the SD card.
+            journaled = *curState;
+        }
     }
     return *curState;
 }
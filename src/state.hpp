@@ -1,5 +1,53 @@
 #pragma once
 #include "json.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
 using json = nlohmann::json;
+/**
+ * Saves the state to the SD card, by appending what changed since the last
+ * save to a journal. Once the journal outgrows the full snapshot, a new
+ * snapshot is written in the background.
+ * 
+ * This only copies the state and returns; a low-priority task writes it
+ * once saves stop coming for 100 ms, or at most 1 s after the first. So
+ * it's safe to call while holding a lock other tasks are waiting on.
+ */
 void saveState();
 json& getState();
+
+/**
+ * Adds a function to call with each copy of the state the writer task
+ * writes, on that task. Anything cached from the state uses this to know
+ * it's stale. A burst of saves calls it once, with the last copy, and
+ * saveState() never waits for it.
+ */
+void onStateSaved(std::function<void(const nlohmann::json&)> listener);
+
+///Number of buckets in each SaveStats histogram.
+const int saveLatencyBuckets = 8;
+///Upper bounds of every bucket but the last, in ms. The last counts everything slower.
+const uint32_t saveLatencyBounds[saveLatencyBuckets - 1] = {5, 10, 20, 50, 100, 200, 500};
+
+/**
+ * Counts of saves, and histograms of how long their SD card writes took.
+ * Each field is a separate atomic, so any task can read them at any time.
+ */
+struct SaveStats {
+  ///Number of saveState() calls.
+  std::atomic<uint32_t> requested{0};
+  ///Number of journal records written. Fewer than requested when saves are coalesced.
+  std::atomic<uint32_t> written{0};
+  ///Longest write, in ms.
+  std::atomic<uint32_t> maxLatency{0};
+  ///Latencies of journal appends, bucketed by saveLatencyBounds.
+  std::atomic<uint32_t> journalWrites[saveLatencyBuckets] = {};
+  ///Latencies of snapshot rewrites, bucketed by saveLatencyBounds.
+  std::atomic<uint32_t> snapshotWrites[saveLatencyBuckets] = {};
+};
+
+///Gets the statistics of the save writer.
+const SaveStats& getSaveStats();
+
+///Clears the statistics of the save writer.
+void resetSaveStats();
@@ -0,0 +1,262 @@
+/**
+ * @file sysid.cpp
+ *
+ * This file defines the drivetrain characterization routine, which drives
+ * the base through voltage ramps & steps and fits TrueSpeed data and
+ * feedforward constants to what it measured.
+ */
+
+#include "main.h"
+#include "sysid.hpp"
+#include "elliot.hpp"
+#include "jobs.hpp"
+#include "gps.hpp"
+#include "battery.hpp"
+#include <algorithm>
+#include <cmath>
+
+///How fast the quasistatic test raises voltage, in mV per second.
+const double rampRate = 1000;
+///Voltages the step test applies, in mV.
+const int stepVoltages[] = {4000, 8000, 12000};
+///Longest a single step may run, in ms.
+const uint32_t stepTimeout = 1500;
+///Time after a ramp restarts before its samples count as quasistatic, in ms.
+const uint32_t rampSettleTime = 300;
+/**
+ * How many times the acceleration the ramp itself causes a sample may have
+ * and still count as quasistatic. Each ramp run starts from standstill, so
+ * this keeps the base's spin-up out of the TrueSpeed fit however long it takes.
+ */
+const double quasistaticAccelMargin = 2;
+///Time to let the robot stop between tests, in ms.
+const uint32_t restTime = 500;
+///Slowest velocity, in deg/s, a sample can have and still be used by the fit.
+const double minFitVelocity = 10;
+///Number of velocity bins the TrueSpeed curve is built from.
+const int trueSpeedBins = 10;
+
+///Raw log entry, before velocity & acceleration are differentiated out.
+struct RawSample {
+  uint32_t time;
+  double voltage;
+  double position;
+  ///Test this sample belongs to. Derivatives never cross tests.
+  int test;
+  bool quasistatic;
+};
+
+/**
+ * Solves a 3x3 linear system by Gaussian elimination with partial pivoting.
+ *
+ * @return Whether the system had a unique solution
+ */
+static bool solve3(double a[3][3], double b[3], double x[3]) {
+  for(int col = 0; col < 3; col++) {
+    int pivot = col;
+    for(int row = col + 1; row < 3; row++) {
+      if(std::abs(a[row][col]) > std::abs(a[pivot][col])) pivot = row;
+    }
+    if(std::abs(a[pivot][col]) < 1e-12) return false;
+    std::swap(a[col], a[pivot]);
+    std::swap(b[col], b[pivot]);
+    for(int row = col + 1; row < 3; row++) {
+      double factor = a[row][col] / a[col][col];
+      for(int k = col; k < 3; k++) a[row][k] -= factor * a[col][k];
+      b[row] -= factor * b[col];
+    }
+  }
+  for(int row = 2; row >= 0; row--) {
+    double sum = b[row];
+    for(int k = row + 1; k < 3; k++) sum -= a[row][k] * x[k];
+    x[row] = sum / a[row][row];
+  }
+  return true;
+}
+
+Feedforward fitFeedforward(const std::vector<SysIdSample>& samples, double& rSquared) {
+  //Normal equations for voltage = [sgn(v), v, a] . [kS, kV, kA]
+  double xtx[3][3] = {}, xty[3] = {};
+  double sumY = 0, sumYY = 0;
+  int n = 0;
+  for(auto &s: samples) {
+    if(std::abs(s.velocity) < minFitVelocity) continue;
+    const double row[3] = {s.velocity > 0 ? 1.0 : -1.0, s.velocity, s.acceleration};
+    for(int i = 0; i < 3; i++) {
+      for(int j = 0; j < 3; j++) xtx[i][j] += row[i] * row[j];
+      xty[i] += row[i] * s.voltage;
+    }
+    sumY += s.voltage;
+    sumYY += s.voltage * s.voltage;
+    n++;
+  }
+  Feedforward ret;
+  double k[3] = {0, 0, 0};
+  rSquared = 0;
+  if(n < 3 || !solve3(xtx, xty, k)) return ret;
+  //Sum of squared residuals, from the same sums as the fit
+  double ssRes = 0;
+  for(auto &s: samples) {
+    if(std::abs(s.velocity) < minFitVelocity) continue;
+    double predicted = (s.velocity > 0 ? k[0] : -k[0]) + k[1] * s.velocity + k[2] * s.acceleration;
+    ssRes += (s.voltage - predicted) * (s.voltage - predicted);
+  }
+  double ssTot = sumYY - sumY * sumY / n;
+  rSquared = ssTot > 0 ? 1 - ssRes / ssTot : 0;
+  //Negative constants are noise, and would make feedforward push the wrong way.
+  ret.kS = std::max(k[0], 0.0);
+  ret.kV = std::max(k[1], 0.0);
+  ret.kA = std::max(k[2], 0.0);
+  return ret;
+}
+
+std::vector<TrueSpeedPoint> fitTrueSpeed(const std::vector<SysIdSample>& samples, double maxVelocity) {
+  double sumX[trueSpeedBins] = {}, sumY[trueSpeedBins] = {};
+  int count[trueSpeedBins] = {};
+  for(auto &s: samples) {
+    if(!s.quasistatic || std::abs(s.velocity) < minFitVelocity) continue;
+    double x = std::min(std::abs(s.velocity) / maxVelocity, 1.0);
+    int bin = std::min((int)(x * trueSpeedBins), trueSpeedBins - 1);
+    sumX[bin] += x;
+    sumY[bin] += std::min(std::abs(s.voltage) / 12000.0, 1.0);
+    count[bin]++;
+  }
+  std::vector<TrueSpeedPoint> ret = {{0, 0}};
+  for(int i = 0; i < trueSpeedBins; i++) {
+    if(!count[i]) continue;
+    TrueSpeedPoint pt = {sumX[i] / count[i], sumY[i] / count[i]};
+    //Bins are in order of x, so only y has to be kept from going backwards.
+    pt.y = std::max(pt.y, ret.back().y);
+    if(pt.x > ret.back().x) ret.push_back(pt);
+  }
+  return ret;
+}
+
+/**
+ * Runs one test, logging a sample every loop period until the robot has
+ * travelled travelLimit, the voltage function says to stop, or B is pressed.
+ *
+ * @param log         Where to add samples
+ * @param test        Index of this test
+ * @param direction   1 to drive forwards, -1 backwards
+ * @param voltage     Gives the voltage magnitude, in mV, for ms since the test started, or a negative value to stop
+ * @param quasistatic Whether samples after rampSettleTime may be quasistatic
+ * @return Whether the test wasn't aborted
+ */
+template <typename F>
+static bool runTest(std::vector<RawSample>& log, int test, int direction, F voltage,
+bool quasistatic, double travelLimit, uint32_t period) {
+  auto &bot = getRobot();
+  //Read the same encoders as the base, so faulted motors are left out.
+  auto position = [&bot]() {
+    return (bot.driveMonitor.getPosition(DriveMonitor::LEFT) + bot.driveMonitor.getPosition(DriveMonitor::RIGHT)) / 2;
+  };
+  const double startPos = position();
+  const double limit = bot.gps.inchToCounts(travelLimit);
+  const uint32_t start = pros::millis();
+  uint32_t now = start;
+  bool aborted = false;
+  while(true) {
+    if(jobCancelled()) {
+      aborted = true;
+      break;
+    }
+    const uint32_t elapsed = pros::millis() - start;
+    const double mV = voltage(elapsed);
+    const double pos = position();
+    if(mV < 0 || std::abs(pos - startPos) >= limit) break;
+    bot.left .moveVoltage(direction * mV);
+    bot.right.moveVoltage(direction * mV);
+    //Log the voltage the motors would have seen at nominal battery voltage,
+    //so the fit matches output that's battery compensated.
+    const double effective = direction * mV * getBatteryVoltage() / nominalBatteryVoltage;
+    log.push_back({pros::millis(), effective, pos, test, quasistatic && elapsed >= rampSettleTime});
+    pros::c::task_delay_until(&now, period);
+  }
+  bot.left .moveVoltage(0);
+  bot.right.moveVoltage(0);
+  jobDelay(restTime);
+  return !aborted;
+}
+
+/**
+ * Turns raw samples into velocities & accelerations, by central
+ * differences over two samples either side. Samples logged as quasistatic
+ * only stay so if their acceleration is at most maxQuasistaticAccel.
+ */
+static std::vector<SysIdSample> differentiate(const std::vector<RawSample>& log, double maxQuasistaticAccel) {
+  const int n = log.size();
+  const int k = 2;
+  std::vector<double> velocity(n, NAN);
+  std::vector<SysIdSample> ret;
+  for(int i = k; i < n - k; i++) {
+    if(log[i - k].test != log[i].test || log[i + k].test != log[i].test) continue;
+    double dt = (log[i + k].time - log[i - k].time) / 1000.0;
+    if(dt > 0) velocity[i] = (log[i + k].position - log[i - k].position) / dt;
+  }
+  for(int i = 2 * k; i < n - 2 * k; i++) {
+    if(std::isnan(velocity[i]) || std::isnan(velocity[i - k]) || std::isnan(velocity[i + k])) continue;
+    if(log[i - k].test != log[i].test || log[i + k].test != log[i].test) continue;
+    double dt = (log[i + k].time - log[i - k].time) / 1000.0;
+    if(dt <= 0) continue;
+    const double acceleration = (velocity[i + k] - velocity[i - k]) / dt;
+    const bool quasistatic = log[i].quasistatic && std::abs(acceleration) <= maxQuasistaticAccel;
+    ret.push_back({log[i].voltage, velocity[i], acceleration, quasistatic});
+  }
+  return ret;
+}
+
+bool characterizeDrive(SysIdResult& result, double travelLimit) {
+  auto &bot = getRobot();
+  //Keep the base's own loop from fighting the test voltages.
+  bot.base->stop();
+  const uint32_t period = std::max<uint32_t>(1, bot.base->getLoopPeriod().convert(millisecond));
+  std::vector<RawSample> log;
+  log.reserve(8192);
+  int test = 0;
+  int direction = 1;
+
+  //Quasistatic: one slow ramp, split into runs that turn around at travelLimit.
+  double rampVoltage = 0;
+  while(rampVoltage < 12000) {
+    const double startVoltage = rampVoltage;
+    jobProgress("Ramp " + std::to_string((int)(rampVoltage / 1000)) + "V");
+    bool ok = runTest(log, test++, direction, [&](uint32_t ms) {
+      rampVoltage = startVoltage + rampRate * ms / 1000.0;
+      return rampVoltage < 12000 ? rampVoltage : -1.0;
+    }, true, travelLimit, period);
+    if(!ok) return false;
+    direction *= -1;
+  }
+
+  //Steps: jump straight to a voltage, and watch the base accelerate.
+  for(int mV: stepVoltages) {
+    for(int stepDirection: {direction, -direction}) {
+      jobProgress("Step " + std::to_string(mV / 1000) + "V");
+      bool ok = runTest(log, test++, stepDirection, [mV](uint32_t ms) {
+        return ms < stepTimeout ? (double)mV : -1.0;
+      }, false, travelLimit, period);
+      if(!ok) return false;
+    }
+  }
+
+  const double maxVelocity = (int)bot.left.getGearing() * 6.0;
+  //At steady state the ramp speeds the base up by about this much, in deg/s^2.
+  const double rampAccel = maxVelocity * rampRate / 12000;
+  auto samples = differentiate(log, quasistaticAccelMargin * rampAccel);
+  result.feedforward = fitFeedforward(samples, result.rSquared);
+  result.trueSpeed = fitTrueSpeed(samples, maxVelocity);
+  result.topSpeed = 0;
+  result.samples = 0;
+  for(auto &s: samples) {
+    result.topSpeed = std::max(result.topSpeed, std::abs(s.velocity));
+    if(std::abs(s.velocity) >= minFitVelocity) result.samples++;
+  }
+  printf("Drive characterization: %d samples, r^2 %f\n", result.samples, result.rSquared);
+  printf("kS %f mV, kV %f mV/(deg/s), kA %f mV/(deg/s^2), top speed %f deg/s\n",
+    result.feedforward.kS, result.feedforward.kV, result.feedforward.kA, result.topSpeed);
+  for(auto &pt: result.trueSpeed) {
+    printf("%f,%f\n", pt.x, pt.y);
+  }
+  return true;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file sysid.hpp
+ *
+ * This file declares the drivetrain characterization routine, which drives
+ * the base through voltage ramps & steps and fits TrueSpeed data and
+ * feedforward constants to what it measured.
+ */
+
+#pragma once
+#include "ccpid_mod.hpp"
+#include <vector>
+
+///One logged loop tick of a characterization run.
+struct SysIdSample {
+  ///Voltage applied to both sides, in mV.
+  double voltage;
+  ///Velocity of the base, in motor degrees per second.
+  double velocity;
+  ///Acceleration of the base, in motor degrees per second squared.
+  double acceleration;
+  ///Whether this was a ramp sample whose measured acceleration was negligible.
+  bool quasistatic;
+};
+
+///Everything fit from a characterization run.
+struct SysIdResult {
+  ///Fitted kS, kV & kA. Profile limits are left at 0 for the caller to fill in.
+  Feedforward feedforward;
+  ///TrueSpeed curve built from the quasistatic ramps.
+  std::vector<TrueSpeedPoint> trueSpeed;
+  ///Fraction of voltage variance explained by the feedforward fit.
+  double rSquared;
+  ///Fastest velocity seen, in motor degrees per second.
+  double topSpeed;
+  ///Number of samples the fit used.
+  int samples;
+};
+
+/**
+ * Fits kS, kV & kA by least squares over every sample that's moving, so
+ * voltage = kS * sgn(velocity) + kV * velocity + kA * acceleration.
+ *
+ * @param samples  Samples to fit
+ * @param rSquared Where to write the fit's coefficient of determination
+ * @return Fitted constants, with profile limits left at 0
+ */
+Feedforward fitFeedforward(const std::vector<SysIdSample>& samples, double& rSquared);
+
+/**
+ * Builds a TrueSpeed curve by averaging the quasistatic samples into
+ * velocity bins. The curve starts at {0, 0}, and is kept monotonic.
+ *
+ * @param samples     Samples to build the curve from
+ * @param maxVelocity Velocity of the motors at full speed, in degrees per second
+ */
+std::vector<TrueSpeedPoint> fitTrueSpeed(const std::vector<SysIdSample>& samples, double maxVelocity);
+
+/**
+ * Characterizes the base in one pass, without any help. It ramps voltage
+ * slowly (quasistatic), then applies voltage steps, logging velocity &
+ * acceleration at the base's loop rate. Each test alternates direction and
+ * stops after travelLimit, so the robot stays within a few feet.
+ *
+ * Cancelling the job running it (see runJob()) aborts the run.
+ *
+ * @param result      Where to write the fit
+ * @param travelLimit Furthest the robot may drive in one direction, in inches
+ * @return Whether the run finished and result is valid
+ */
+bool characterizeDrive(SysIdResult& result, double travelLimit = 36);
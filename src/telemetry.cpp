@@ -0,0 +1,160 @@
+/**
+ * @file telemetry.cpp
+ *
+ * This file defines the telemetry service, which reads every motor once
+ * per tick into a snapshot that the rest of the robot shares.
+ */
+
+#include "main.h"
+#include "telemetry.hpp"
+#include "gps.hpp"
+#include "driveMonitor.hpp"
+#include "battery.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * Snapshots are double buffered. The daemon fills buffers[n & 1] for its
+ * nth write, marking the write as started in \ref started and as done in
+ * \ref published. A reader copies buffers[published & 1], and only has to
+ * retry if, by the time it's done, the daemon has started writing that
+ * buffer again.
+ */
+static TelemetrySnapshot buffers[2];
+///Number of the last write started. Only the daemon writes this.
+static std::atomic<uint32_t> started{0};
+///Number of the last write finished. Only the daemon writes this.
+static std::atomic<uint32_t> published{0};
+///Whether each port is sampled. Written before the daemon starts.
+static bool sampled[telemetryPorts];
+///GPS to sample, if any. Written before the daemon starts.
+static GPS* sampledGPS = nullptr;
+///DriveMonitor to update after each tick, if any. Written before the daemon starts.
+static DriveMonitor* updatedMonitor = nullptr;
+///Time between samples, in ms.
+static std::atomic<uint32_t> period{defaultTelemetryPeriod};
+///Most tasks that can be woken after each tick.
+const int maxSubscribers = 4;
+///Tasks woken after each tick. Empty slots are nullptr.
+static pros::task_t subscribers[maxSubscribers];
+///Guards \ref subscribers, so a task can't end while it's being woken.
+static pros::Mutex subscriberLock;
+///Base loop state from publishBaseStatus(). Each field is its own atomic, so the loop never waits.
+static std::atomic<double> baseError{0};
+static std::atomic_bool baseSettled{true};
+static std::atomic<uint32_t> baseJitter{0}, baseMaxJitter{0}, baseOverruns{0};
+
+static void telemetryDaemon(void*) {
+  uint32_t lastTime = pros::millis();
+  while(true) {
+    const uint32_t n = published.load(std::memory_order_relaxed) + 1;
+    started.store(n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto &snapshot = buffers[n & 1];
+    snapshot.time = pros::millis();
+    snapshot.tick = n;
+    for(int i = 0; i < telemetryPorts; i++) {
+      auto &sample = snapshot.motors[i];
+      if(!sampled[i]) {
+        sample.valid = false;
+        continue;
+      }
+      const uint8_t port = i + 1;
+      sample.position = pros::c::motor_get_position(port);
+      sample.velocity = pros::c::motor_get_actual_velocity(port);
+      sample.current = pros::c::motor_get_current_draw(port);
+      sample.voltage = pros::c::motor_get_voltage(port);
+      sample.temperature = pros::c::motor_get_temperature(port);
+      //PROS reports an unplugged motor as PROS_ERR_F or PROS_ERR.
+      sample.valid = std::isfinite(sample.position) && sample.position != PROS_ERR_F &&
+                     sample.velocity != PROS_ERR_F && sample.current != PROS_ERR;
+    }
+    if(sampledGPS) {
+      const auto pos = sampledGPS->getPosition();
+      snapshot.x = pos.x;
+      snapshot.y = pos.y;
+      snapshot.o = pos.o;
+    } else {
+      snapshot.x = snapshot.y = snapshot.o = 0;
+    }
+    //The monitor goes first, so its velocities are from this tick's readings.
+    if(updatedMonitor) {
+      updatedMonitor->update(snapshot);
+      snapshot.leftVelocity = updatedMonitor->getVelocity(DriveMonitor::LEFT);
+      snapshot.rightVelocity = updatedMonitor->getVelocity(DriveMonitor::RIGHT);
+      snapshot.leftCurrent = updatedMonitor->getCurrent(DriveMonitor::LEFT);
+      snapshot.rightCurrent = updatedMonitor->getCurrent(DriveMonitor::RIGHT);
+    } else {
+      snapshot.leftVelocity = snapshot.rightVelocity = 0;
+      snapshot.leftCurrent = snapshot.rightCurrent = 0;
+    }
+    snapshot.batteryVoltage = getBatteryVoltage();
+    snapshot.batteryCapacity = getBatteryCapacity();
+    snapshot.base.error = baseError.load(std::memory_order_relaxed);
+    snapshot.base.settled = baseSettled.load(std::memory_order_relaxed);
+    snapshot.base.jitter = baseJitter.load(std::memory_order_relaxed);
+    snapshot.base.maxJitter = baseMaxJitter.load(std::memory_order_relaxed);
+    snapshot.base.overruns = baseOverruns.load(std::memory_order_relaxed);
+    published.store(n, std::memory_order_release);
+    subscriberLock.take(TIMEOUT_MAX);
+    for(auto task: subscribers) {
+      if(task) pros::c::task_notify(task);
+    }
+    subscriberLock.give();
+    pros::c::task_delay_until(&lastTime, period.load(std::memory_order_relaxed));
+  }
+}
+
+void beginTelemetryTask(std::initializer_list<int> ports, GPS* gps, DriveMonitor* monitor) {
+  sampledGPS = gps;
+  updatedMonitor = monitor;
+  for(int port: ports) {
+    sampled[(port < 0 ? -port : port) - 1] = true;
+  }
+  pros::Task daemon(telemetryDaemon, nullptr, TASK_PRIORITY_DEFAULT + 1, TASK_STACK_DEPTH_DEFAULT, "Telemetry");
+}
+
+void publishBaseStatus(const BaseStatus& status) {
+  baseError.store(status.error, std::memory_order_relaxed);
+  baseSettled.store(status.settled, std::memory_order_relaxed);
+  baseJitter.store(status.jitter, std::memory_order_relaxed);
+  baseMaxJitter.store(status.maxJitter, std::memory_order_relaxed);
+  baseOverruns.store(status.overruns, std::memory_order_relaxed);
+}
+
+void getTelemetry(TelemetrySnapshot& out) {
+  while(true) {
+    const uint32_t n = published.load(std::memory_order_acquire);
+    std::memcpy(&out, &buffers[n & 1], sizeof(out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    //The daemon's next write goes to the other buffer, so only the one after that could have torn this copy.
+    if(started.load(std::memory_order_relaxed) - n < 2) return;
+  }
+}
+
+void setTelemetryPeriod(uint32_t periodMs) {
+  period.store(std::clamp(periodMs, minTelemetryPeriod, maxTelemetryPeriod), std::memory_order_relaxed);
+}
+
+uint32_t getTelemetryPeriod() {
+  return period.load(std::memory_order_relaxed);
+}
+
+bool subscribeTelemetry(pros::task_t task) {
+  subscriberLock.take(TIMEOUT_MAX);
+  auto slot = std::find(subscribers, subscribers + maxSubscribers, nullptr);
+  const bool found = slot != subscribers + maxSubscribers;
+  if(found) *slot = task;
+  subscriberLock.give();
+  if(!found) printf("Telemetry: too many subscribers, this one won't be woken\n");
+  return found;
+}
+
+void unsubscribeTelemetry(pros::task_t task) {
+  subscriberLock.take(TIMEOUT_MAX);
+  for(auto &slot: subscribers) {
+    if(slot == task) slot = nullptr;
+  }
+  subscriberLock.give();
+}
@@ -0,0 +1,136 @@
+/**
+ * @file telemetry.hpp
+ *
+ * This file declares the telemetry service, which reads every motor once
+ * per tick into a snapshot that the rest of the robot shares.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include "main.h"
+
+class GPS;
+class DriveMonitor;
+
+///Number of smart ports a snapshot has room for.
+const int telemetryPorts = 21;
+///Time between telemetry samples until setTelemetryPeriod() is called, in ms.
+const uint32_t defaultTelemetryPeriod = 10;
+///Shortest time between telemetry samples, in ms. Reading every motor takes a few ms.
+const uint32_t minTelemetryPeriod = 5;
+///Longest time between telemetry samples, in ms. Odometry drifts when ticks are any further apart.
+const uint32_t maxTelemetryPeriod = 50;
+
+///One motor's readings at a telemetry tick.
+struct MotorSample {
+  ///Whether this port is sampled, and answered this tick.
+  bool valid;
+  ///Position, in the motor's encoder units.
+  double position;
+  ///Velocity, in RPM.
+  double velocity;
+  ///Current draw, in mA.
+  int32_t current;
+  ///Applied voltage, in mV.
+  int32_t voltage;
+  ///Temperature, in degrees Celsius.
+  double temperature;
+};
+
+///State of the base's control loop, as last published by publishBaseStatus().
+struct BaseStatus {
+  ///Error of the PID driving the current movement, in motor degrees.
+  double error;
+  ///Whether the current movement has settled.
+  bool settled;
+  ///How far the last iteration woke from its scheduled time, and the furthest any did, in ms.
+  uint32_t jitter, maxJitter;
+  ///Number of iterations that ran longer than the loop period.
+  uint32_t overruns;
+};
+
+///Every sampled motor's readings at the same tick.
+struct TelemetrySnapshot {
+  ///Time the tick started, in ms.
+  uint32_t time;
+  ///Number of this tick, counting from 1. 0 before the first sample.
+  uint32_t tick;
+  ///Readings, indexed by port - 1.
+  MotorSample motors[telemetryPorts];
+  ///GPS position at this tick, in encoder counts & radians. Zero if no GPS is sampled.
+  double x, y, o;
+  ///Velocity of each side of the base from the DriveMonitor, in RPM. Zero if no monitor is updated.
+  double leftVelocity, rightVelocity;
+  ///Average current draw of each side's motors from the DriveMonitor, in mA. Zero if no monitor is updated.
+  double leftCurrent, rightCurrent;
+  ///Filtered battery voltage in mV, and remaining charge in percent.
+  double batteryVoltage, batteryCapacity;
+  ///Base loop state, from the loop's last iteration.
+  BaseStatus base;
+
+  /**
+   * Gets a motor's readings.
+   *
+   * @param port Port of the motor. Negative (reversed) ports are fine.
+   */
+  const MotorSample& motor(int port) const {
+    return motors[(port < 0 ? -port : port) - 1];
+  }
+};
+
+/**
+ * Starts the daemon that samples the given motors every telemetry period.
+ * Should be called once, from Elliot::beginTasks().
+ *
+ * @param ports   Ports of the motors to sample. Negative (reversed) ports are fine.
+ * @param gps     GPS whose position to sample, or nullptr for none
+ * @param monitor DriveMonitor to update from each tick's snapshot, or nullptr for none
+ */
+void beginTelemetryTask(std::initializer_list<int> ports, GPS* gps = nullptr, DriveMonitor* monitor = nullptr);
+
+/**
+ * Sets the time between telemetry samples. The base loop runs once per
+ * sample, so this is kept equal to its period by BaseSettings.
+ *
+ * @param periodMs Time between samples in ms, clamped to [minTelemetryPeriod, maxTelemetryPeriod]
+ */
+void setTelemetryPeriod(uint32_t periodMs);
+
+///Gets the time between telemetry samples, in ms.
+uint32_t getTelemetryPeriod();
+
+/**
+ * Wakes a task with task_notify() after every tick, once the DriveMonitor
+ * has been updated from the snapshot and the snapshot is published. Loops that
+ * wait with task_notify_take() then never act on the same readings twice.
+ *
+ * @param task Task to wake. Must be unsubscribed with unsubscribeTelemetry() before it's deleted.
+ * @return Whether there was room. If not, the task is never woken.
+ */
+bool subscribeTelemetry(pros::task_t task);
+
+/**
+ * Stops waking a task subscribed with subscribeTelemetry().
+ *
+ * @param task Task to stop waking
+ */
+void unsubscribeTelemetry(pros::task_t task);
+
+/**
+ * Publishes the base loop's state, to be copied into the next snapshot.
+ * Called by the loop itself, so nothing else has to reach into a base that
+ * may be rebuilt at any time.
+ *
+ * @param status State of the loop after this iteration
+ */
+void publishBaseStatus(const BaseStatus& status);
+
+/**
+ * Copies the latest snapshot. Readers never block the daemon, and the
+ * daemon never blocks readers; a copy that raced with a write is retried.
+ *
+ * @param out Where to copy the snapshot
+ */
+void getTelemetry(TelemetrySnapshot& out);